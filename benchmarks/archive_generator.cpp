@@ -0,0 +1,320 @@
+#include "archive_generator.hpp"
+
+#include <md5/md5.hpp>
+#include <miniz/miniz.h>
+
+#include <cmath>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+using namespace bench;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+constexpr uint8_t HEADER[56] = {
+    0x35, 0x32, 0x35, 0x63, 0x31, 0x37, 0x61, 0x36, 0x61, 0x37, 0x63, 0x66, 0x62, 0x63,
+    0x64, 0x37, 0x35, 0x34, 0x31, 0x32, 0x65, 0x63, 0x64, 0x30, 0x36, 0x39, 0x64, 0x34,
+    0x62, 0x37, 0x32, 0x63, 0x33, 0x38, 0x39, 0x00, 0x10, 0x00, 0x00, 0x00, 0x4E, 0x4F,
+    0x52, 0x4D, 0x41, 0x4C, 0x5F, 0x50, 0x41, 0x43, 0x4B, 0x5F, 0x54, 0x59, 0x50, 0x45
+};
+
+constexpr uint8_t KEY[16] = {
+    0x41, 0xF5, 0xDF, 0x98, 0xC2, 0x05, 0x48, 0x2B,
+    0x9B, 0x97, 0xAF, 0x01, 0xA5, 0x4B, 0x14, 0xD8
+};
+
+constexpr uint32_t FORMAT_V1_TYPE = 0x64;
+constexpr uint32_t FORMAT_V2_TYPE = 0x66;
+
+// size of the first chunk the reader decodes, see format_v2.cpp
+constexpr uint32_t READ_CHUNK_SIZE = 16 * 1024;
+constexpr uint32_t TEA_CHUNK_SIZE  = 64;
+
+// entries per directory
+constexpr uint64_t ENTRIES_PER_DIR = 1000U;
+
+// repetitive data source for compressible runs
+constexpr char PHRASE[] =
+    "The quick brown fox jumps over the lazy dog. Sphinx of black quartz, judge my vow. "
+    "Pack my box with five dozen liquor jugs. How vexingly quick daft zebras jump! ";
+
+/*
+    Append little endian u32.
+*/
+static void append_u32(std::vector<uint8_t>& buffer, uint32_t value);
+
+/*
+    Encode the part of the block the reader decodes.
+*/
+static void encode_block(uint8_t* block, uint32_t block_size);
+
+/*
+    TEA algorithm encode.
+*/
+static void TEA_encode(uint8_t data[8], const uint32_t key[4]);
+
+/*
+    Compress and encode a block, stores raw data if it doesn't compress.
+*/
+static void obfuscate(std::vector<uint8_t>& data, std::vector<uint8_t>& out, bool allow_raw);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+bool archive_generator::generate(const std::filesystem::path& output, result& result) {
+    std::ofstream stream(output, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+        return false;
+
+    std::mt19937_64 rng(m_config.seed);
+
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> stored;
+    std::vector<uint8_t> desc;
+
+    append_u32(desc, 5U);
+    desc.insert(desc.end(), { 'b', 'e', 'n', 'c', 'h' });
+    append_u32(desc, 0U);
+    append_u32(desc, 0U);
+    append_u32(desc, 0U);
+
+    // header is rewritten once the desc block is known
+    std::array<uint8_t, 76> header = {};
+    stream.write((const char*)header.data(), header.size());
+
+    uint64_t offset = header.size();
+
+    result = {};
+
+    for (uint64_t i = 0; i < m_config.entry_count; i++) {
+        data.resize(next_size(rng));
+        fill_data(rng, data);
+
+        const uint8_t* src       = data.data();
+        uint32_t       src_size  = (uint32_t)data.size();
+        uint32_t       data_size = (uint32_t)data.size();
+        uint32_t       flags     = 0x1;
+
+        if (m_config.format == format::v2) {
+            obfuscate(data, stored, true);
+
+            src       = stored.data();
+            src_size  = (uint32_t)stored.size();
+            flags    |= 0x4;
+        }
+
+        // hash decompressed data, obfuscate may have changed it
+        std::array<uint8_t, MD5::HashBytes> hash = {};
+
+        MD5 md5;
+        md5.add(data.data(), data.size());
+        md5.getHash(hash.data());
+
+        if (offset + src_size > UINT32_MAX)
+            return false;
+
+        stream.write((const char*)src, src_size);
+
+        std::string name = get_entry_name(i);
+        std::replace(name.begin(), name.end(), '/', '\\');
+
+        append_u32(desc, (uint32_t)name.size());
+        desc.insert(desc.end(), name.begin(), name.end());
+        append_u32(desc, (uint32_t)offset);
+        append_u32(desc, src_size);
+        append_u32(desc, data_size);
+        append_u32(desc, flags);
+        append_u32(desc, 0U);
+        append_u32(desc, 0U);
+        desc.insert(desc.end(), hash.begin(), hash.end());
+
+        offset += src_size;
+
+        result.entry_count++;
+        result.data_size += data_size;
+    }
+
+    uint32_t desc_offset = (uint32_t)offset;
+    uint32_t desc_size   = 0U;
+
+    if (m_config.format == format::v2) {
+        std::vector<uint8_t> block;
+        append_u32(block, (uint32_t)desc.size());
+
+        obfuscate(desc, stored, false);
+        append_u32(block, (uint32_t)stored.size());
+
+        block.insert(block.end(), stored.begin(), stored.end());
+
+        stream.write((const char*)block.data(), block.size());
+        desc_size = (uint32_t)block.size();
+    }
+    else {
+        stream.write((const char*)desc.data(), desc.size());
+        desc_size = (uint32_t)desc.size();
+    }
+
+    std::vector<uint8_t> header_data(HEADER, HEADER + sizeof(HEADER));
+    append_u32(header_data, m_config.format == format::v2 ? FORMAT_V2_TYPE : FORMAT_V1_TYPE);
+    append_u32(header_data, desc_offset);
+    append_u32(header_data, desc_size);
+    append_u32(header_data, (uint32_t)result.entry_count);
+    append_u32(header_data, 0U);
+
+    stream.seekp(0, std::ios::beg);
+    stream.write((const char*)header_data.data(), header_data.size());
+
+    result.archive_size = (uint64_t)desc_offset + desc_size;
+    return stream.good();
+}
+
+std::string archive_generator::get_entry_name(uint64_t index) {
+    char buffer[64] = {};
+    snprintf(buffer, sizeof(buffer), "dir_%04llu/file_%07llu.bin",
+        (unsigned long long)(index / ENTRIES_PER_DIR), (unsigned long long)index);
+
+    return buffer;
+}
+
+bool archive_generator::parse_format(const std::string& str, format& format) {
+    if (str == "v1") { format = format::v1; return true; }
+    if (str == "v2") { format = format::v2; return true; }
+
+    return false;
+}
+
+bool archive_generator::parse_size_dist(const std::string& str, size_dist& dist) {
+    if (str == "fixed")     { dist = size_dist::fixed;     return true; }
+    if (str == "uniform")   { dist = size_dist::uniform;   return true; }
+    if (str == "lognormal") { dist = size_dist::lognormal; return true; }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+uint32_t archive_generator::next_size(std::mt19937_64& rng) const {
+    uint32_t mean = std::max(1U, m_config.mean_size);
+
+    switch (m_config.dist) {
+        case size_dist::uniform: {
+            std::uniform_int_distribution<uint32_t> dist(1U, mean * 2U);
+            return dist(rng);
+        }
+        case size_dist::lognormal: {
+            std::lognormal_distribution<double> dist(std::log((double)mean), 1.0);
+            return (uint32_t)std::clamp(dist(rng), 1.0, (double)mean * 64.0);
+        }
+        default: return mean;
+    }
+}
+
+void archive_generator::fill_data(std::mt19937_64& rng, std::vector<uint8_t>& data) const {
+    constexpr uint32_t RUN_SIZE    = 64;
+    constexpr uint32_t PHRASE_SIZE = sizeof(PHRASE) - 1;
+
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    for (size_t pos = 0; pos < data.size(); pos += RUN_SIZE) {
+        size_t run = std::min<size_t>(RUN_SIZE, data.size() - pos);
+
+        if (chance(rng) < m_config.compressibility) {
+            size_t start = (size_t)(rng() % PHRASE_SIZE);
+
+            for (size_t i = 0; i < run; i++)
+                data[pos + i] = (uint8_t)PHRASE[(start + i) % PHRASE_SIZE];
+        }
+        else {
+            for (size_t i = 0; i < run; i += 8) {
+                uint64_t value = rng();
+                memcpy(data.data() + pos + i, &value, std::min<size_t>(8, run - i));
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+void append_u32(std::vector<uint8_t>& buffer, uint32_t value) {
+    buffer.push_back((uint8_t)(value));
+    buffer.push_back((uint8_t)(value >> 8));
+    buffer.push_back((uint8_t)(value >> 16));
+    buffer.push_back((uint8_t)(value >> 24));
+}
+
+void encode_block(uint8_t* block, uint32_t block_size) {
+    block_size = std::min(block_size, READ_CHUNK_SIZE);
+
+    // mirrors decode_block, including its small block rounding
+    uint32_t encode_size = TEA_CHUNK_SIZE;
+    if (TEA_CHUNK_SIZE >= block_size) {
+        if (block_size == 0) return;
+
+        encode_size  = block_size - 1;
+        encode_size &= ~7U;
+    }
+
+    uint32_t key[4] = {};
+    memcpy(key, KEY, sizeof(KEY));
+
+    for (uint32_t i = 0; i < encode_size / 8; i++) {
+        TEA_encode(block + (i * 8), key);
+    }
+}
+
+void TEA_encode(uint8_t data[8], const uint32_t key[4]) {
+    uint32_t delta = 0x9E3779B9;
+    uint32_t sum   = 0U;
+
+    uint32_t v0 = ((uint32_t)data[0])
+                | ((uint32_t)data[1] << 8)
+                | ((uint32_t)data[2] << 16)
+                | ((uint32_t)data[3] << 24);
+
+    uint32_t v1 = ((uint32_t)data[4])
+                | ((uint32_t)data[5] << 8)
+                | ((uint32_t)data[6] << 16)
+                | ((uint32_t)data[7] << 24);
+
+    for (uint32_t i = 0; i < 32; i++) {
+        sum += delta;
+
+        v0 += ((v1 << 4) + key[0]) ^ (v1 + sum) ^ ((v1 >> 5) + key[1]);
+        v1 += ((v0 << 4) + key[2]) ^ (v0 + sum) ^ ((v0 >> 5) + key[3]);
+    }
+
+    data[0] = (uint8_t)(v0);
+    data[1] = (uint8_t)(v0 >> 8);
+    data[2] = (uint8_t)(v0 >> 16);
+    data[3] = (uint8_t)(v0 >> 24);
+    data[4] = (uint8_t)(v1);
+    data[5] = (uint8_t)(v1 >> 8);
+    data[6] = (uint8_t)(v1 >> 16);
+    data[7] = (uint8_t)(v1 >> 24);
+}
+
+void obfuscate(std::vector<uint8_t>& data, std::vector<uint8_t>& out, bool allow_raw) {
+    mz_ulong size = mz_compressBound((mz_ulong)data.size());
+    out.resize(size);
+
+    if (mz_compress2(out.data(), &size, data.data(), (mz_ulong)data.size(), MZ_DEFAULT_LEVEL) != MZ_OK)
+        size = (mz_ulong)data.size() + 1;
+
+    if (allow_raw && size >= (mz_ulong)data.size()) {
+        // reader treats raw data starting with zlib magic as compressed
+        if (data.size() >= 2 && data[0] == 0x78)
+            data[0] ^= 0x1;
+
+        out.assign(data.begin(), data.end());
+    }
+    else {
+        out.resize(size);
+    }
+
+    encode_block(out.data(), (uint32_t)out.size());
+}
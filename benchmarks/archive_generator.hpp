@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <filesystem>
+
+namespace bench {
+    /*
+        Synthetic archive generator
+
+        Writes archives directly in the on-disk layout so that large entry counts
+        and format v2 (not supported by evp::pack) can be produced.
+    */
+    class archive_generator {
+    public:
+        enum class format : uint8_t {
+            v1 = 0x0,   // stored entries
+            v2 = 0x1    // zlib compressed, TEA encoded entries and desc block
+        };
+
+        enum class size_dist : uint8_t {
+            fixed     = 0x0,   // every entry is mean_size
+            uniform   = 0x1,   // uniform in [1, 2 * mean_size]
+            lognormal = 0x2    // lognormal with median mean_size, sigma 1, capped at 64 * mean_size
+        };
+
+        struct config {
+            uint64_t                   entry_count     = 10000U;
+            uint32_t                   mean_size       = 4096U;
+            size_dist                  dist            = size_dist::fixed;
+            double                     compressibility = 0.5;   // 0 random, 1 highly repetitive
+            archive_generator::format  format          = archive_generator::format::v1;
+            uint64_t                   seed            = 1U;
+        };
+
+        struct result {
+            uint64_t entry_count  = 0U;
+            uint64_t data_size    = 0U;   // sum of decompressed entry sizes
+            uint64_t archive_size = 0U;
+        };
+
+    public:
+        archive_generator(const config& config)
+            : m_config(config) {}
+
+    public:
+
+        /*
+            Generate archive.
+
+            @returns true if written
+        */
+        bool generate(const std::filesystem::path& output, result& result);
+
+    public:
+
+        /*
+            Get name of nth entry.
+        */
+        static std::string get_entry_name(uint64_t index);
+
+        static bool parse_format(const std::string& str, format& format);
+        static bool parse_size_dist(const std::string& str, size_dist& dist);
+
+    private:
+        config m_config;
+
+    private:
+        uint32_t next_size(std::mt19937_64& rng) const;
+        void     fill_data(std::mt19937_64& rng, std::vector<uint8_t>& data) const;
+    };
+}
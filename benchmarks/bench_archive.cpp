@@ -0,0 +1,301 @@
+/*
+    End-to-end archive benchmark.
+
+    Generates a synthetic archive and measures archive level operations.
+    Results are printed as JSON, run with --help for options.
+*/
+
+#include "bench_common.hpp"
+#include "archive_generator.hpp"
+
+#include <libevp.hpp>
+
+#include <random>
+#include <algorithm>
+#include <functional>
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+struct bench_input {
+    uint64_t bytes   = 0U;   // bytes processed per run
+    uint64_t entries = 0U;   // entries processed per run
+    uint32_t runs    = 1U;
+};
+
+/*
+    Run operation multiple times and describe best and mean run.
+*/
+static bench::json_object measure(const std::string& name, const bench_input& input,
+    const std::function<bool()>& prepare, const std::function<bool()>& run);
+
+/*
+    Measure get_file latency over random entries.
+*/
+static bench::json_object measure_get_file(evp& evp, const FILE_PATH& archive,
+    const std::vector<evp_fd>& fds, uint64_t samples, uint64_t seed);
+
+static void print_usage();
+
+///////////////////////////////////////////////////////////////////////////////
+// MAIN
+
+int main(int argc, char** argv) {
+    bench::args args(argc, argv);
+
+    if (args.has("help")) {
+        print_usage();
+        return 0;
+    }
+
+    bench::archive_generator::config config;
+    config.entry_count     = args.get("entries", (uint64_t)10000U);
+    config.mean_size       = (uint32_t)args.get("size", (uint64_t)4096U);
+    config.compressibility = args.get("compressibility", 0.5);
+    config.seed            = args.get("seed", (uint64_t)1U);
+
+    if (!bench::archive_generator::parse_format(args.get("format", std::string("v1")), config.format) ||
+        !bench::archive_generator::parse_size_dist(args.get("dist", std::string("fixed")), config.dist))
+    {
+        print_usage();
+        return 1;
+    }
+
+    uint32_t    runs    = (uint32_t)std::max<uint64_t>(1U, args.get("runs", (uint64_t)3U));
+    uint64_t    samples = args.get("samples", (uint64_t)1000U);
+    std::string ops     = args.get("ops", std::string("fds,validate,unpack,get_file,pack"));
+
+    std::filesystem::path work_dir = args.get("work-dir",
+        (std::filesystem::temp_directory_path() / "libevp_bench").string());
+
+    std::filesystem::path archive     = work_dir / "bench.evp";
+    std::filesystem::path unpack_dir  = work_dir / "unpacked";
+    std::filesystem::path pack_output = work_dir / "packed.evp";
+
+    std::error_code ec;
+    std::filesystem::remove_all(work_dir, ec);
+    std::filesystem::create_directories(work_dir, ec);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // GENERATE
+
+    bench::archive_generator::result generated;
+    bench::timer                     timer;
+
+    if (!bench::archive_generator(config).generate(archive, generated)) {
+        fprintf(stderr, "Failed to generate archive.\n");
+        return 1;
+    }
+
+    double generate_s = timer.elapsed_s();
+
+    bench::json_object json_config;
+    json_config.add("entries",         config.entry_count);
+    json_config.add("mean_size",       (uint64_t)config.mean_size);
+    json_config.add("dist",            args.get("dist", std::string("fixed")));
+    json_config.add("compressibility", config.compressibility);
+    json_config.add("format",          args.get("format", std::string("v1")));
+    json_config.add("seed",            config.seed);
+    json_config.add("runs",            (uint64_t)runs);
+
+    bench::json_object json_archive;
+    json_archive.add("entries",      generated.entry_count);
+    json_archive.add("data_size",    generated.data_size);
+    json_archive.add("archive_size", generated.archive_size);
+    json_archive.add("generate_s",   generate_s);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // RUN
+
+    evp                             evp;
+    std::vector<evp_fd>             fds;
+    std::vector<bench::json_object> results;
+
+    if (!evp.get_archive_fds(archive, fds)) {
+        fprintf(stderr, "Failed to read generated archive.\n");
+        return 1;
+    }
+
+    auto enabled = [&](const std::string& op) {
+        return ("," + ops + ",").find("," + op + ",") != std::string::npos;
+    };
+
+    if (enabled("fds")) {
+        std::vector<evp_fd> tmp;
+
+        results.push_back(measure("get_archive_fds", { 0U, generated.entry_count, runs },
+            [&] { tmp.clear(); return true; },
+            [&] { return (bool)evp.get_archive_fds(archive, tmp); }));
+    }
+
+    if (enabled("validate")) {
+        results.push_back(measure("validate_files", { generated.data_size, generated.entry_count, runs },
+            nullptr,
+            [&] { return (bool)evp.validate_files(archive); }));
+    }
+
+    // pack reads unpacked files
+    if (enabled("unpack") || enabled("pack")) {
+        evp::unpack_input input;
+        input.archive = archive;
+
+        results.push_back(measure("unpack", { generated.data_size, generated.entry_count, runs },
+            [&] {
+                std::error_code ec;
+                std::filesystem::remove_all(unpack_dir, ec);
+                return std::filesystem::create_directories(unpack_dir, ec);
+            },
+            [&] { return (bool)evp.unpack(input, unpack_dir); }));
+    }
+
+    if (enabled("get_file")) {
+        results.push_back(measure_get_file(evp, archive, fds, samples, config.seed));
+    }
+
+    if (enabled("pack")) {
+        evp::pack_input input;
+        input.base = unpack_dir;
+
+        for (const auto& fd : fds) {
+            input.files.push_back(fd.file);
+        }
+
+        results.push_back(measure("pack", { generated.data_size, generated.entry_count, runs },
+            [&] {
+                std::error_code ec;
+                std::filesystem::remove(pack_output, ec);
+                return true;
+            },
+            [&] { return (bool)evp.pack(input, pack_output); }));
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // OUTPUT
+
+    bench::json_object json;
+    json.add("benchmark",   "archive");
+    json.add("config",      json_config);
+    json.add("archive",     json_archive);
+    json.add("results",     results);
+    json.add("peak_rss_kb", bench::get_peak_rss_kb());
+
+    if (!args.has("keep"))
+        std::filesystem::remove_all(work_dir, ec);
+
+    if (!bench::output_json(json, args.get("output", std::string("")))) {
+        fprintf(stderr, "Failed to write output.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+bench::json_object measure(const std::string& name, const bench_input& input,
+    const std::function<bool()>& prepare, const std::function<bool()>& run)
+{
+    double best  = 0.0;
+    double total = 0.0;
+    bool   ok    = true;
+
+    for (uint32_t i = 0; i < input.runs; i++) {
+        if (prepare && !prepare()) {
+            ok = false;
+            break;
+        }
+
+        bench::timer timer;
+        ok = run();
+
+        double elapsed = timer.elapsed_s();
+        if (!ok) break;
+
+        total += elapsed;
+        best   = i == 0 ? elapsed : std::min(best, elapsed);
+    }
+
+    bench::json_object json;
+    json.add("name",   name);
+    json.add("ok",     ok);
+    json.add("best_s", best);
+    json.add("mean_s", total / input.runs);
+
+    if (best > 0.0) {
+        if (input.bytes)
+            json.add("mb_s", (double)input.bytes / (1024.0 * 1024.0) / best);
+
+        if (input.entries)
+            json.add("entries_s", (double)input.entries / best);
+    }
+
+    json.add("peak_rss_kb", bench::get_peak_rss_kb());
+    return json;
+}
+
+bench::json_object measure_get_file(evp& evp, const FILE_PATH& archive,
+    const std::vector<evp_fd>& fds, uint64_t samples, uint64_t seed)
+{
+    std::mt19937_64                       rng(seed);
+    std::uniform_int_distribution<size_t> pick(0U, fds.empty() ? 0U : fds.size() - 1);
+    std::vector<double>                   latencies;
+    std::vector<uint8_t>                  buffer;
+
+    uint64_t bytes = 0U;
+    bool     ok    = !fds.empty();
+
+    latencies.reserve(samples);
+
+    for (uint64_t i = 0; ok && i < samples; i++) {
+        const evp_fd& fd = fds[pick(rng)];
+
+        bench::timer timer;
+        ok = (bool)evp.get_file(archive, fd, buffer);
+
+        latencies.push_back(timer.elapsed_s());
+        bytes += buffer.size();
+    }
+
+    bench::json_object json;
+    json.add("name", "get_file");
+    json.add("ok",   ok);
+
+    if (ok && !latencies.empty()) {
+        double total = 0.0;
+        for (double latency : latencies)
+            total += latency;
+
+        std::sort(latencies.begin(), latencies.end());
+
+        json.add("samples",   (uint64_t)latencies.size());
+        json.add("mean_us",   total / latencies.size() * 1e6);
+        json.add("p50_us",    latencies[latencies.size() / 2] * 1e6);
+        json.add("p99_us",    latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] * 1e6);
+        json.add("max_us",    latencies.back() * 1e6);
+        json.add("mb_s",      (double)bytes / (1024.0 * 1024.0) / total);
+        json.add("entries_s", (double)latencies.size() / total);
+    }
+
+    json.add("peak_rss_kb", bench::get_peak_rss_kb());
+    return json;
+}
+
+void print_usage() {
+    fprintf(stderr,
+        "usage: bench_archive [options]\n"
+        "  --entries N            entry count (default 10000)\n"
+        "  --size N               mean entry size in bytes (default 4096)\n"
+        "  --dist D               fixed | uniform | lognormal (default fixed)\n"
+        "  --compressibility C    0.0 - 1.0 (default 0.5)\n"
+        "  --format F             v1 | v2 (default v1)\n"
+        "  --seed N               generator seed (default 1)\n"
+        "  --runs N               runs per operation (default 3)\n"
+        "  --samples N            get_file samples (default 1000)\n"
+        "  --ops LIST             fds,validate,unpack,get_file,pack\n"
+        "  --work-dir PATH        scratch directory (default temp)\n"
+        "  --output PATH          write JSON to file instead of stdout\n"
+        "  --keep                 keep scratch directory\n");
+}
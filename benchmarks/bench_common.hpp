@@ -0,0 +1,202 @@
+#pragma once
+
+#include <map>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+    #define NOMINMAX
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace bench {
+    /*
+        Monotonic stopwatch.
+    */
+    class timer {
+    public:
+        timer()
+            : m_start(std::chrono::steady_clock::now()) {}
+
+    public:
+        void reset() {
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        double elapsed_s() const {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /*
+        Get peak resident set size of the process in KiB.
+    */
+    inline uint64_t get_peak_rss_kb() {
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0U;
+
+        return (uint64_t)counters.PeakWorkingSetSize / 1024U;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0U;
+
+    #if defined(__APPLE__)
+        return (uint64_t)usage.ru_maxrss / 1024U;
+    #else
+        return (uint64_t)usage.ru_maxrss;
+    #endif
+#endif
+    }
+
+    /*
+        Flat JSON object writer.
+        Values are kept in insertion order, nested objects are added as raw JSON.
+    */
+    class json_object {
+    public:
+        void add(const std::string& key, const std::string& value) {
+            std::string escaped = "\"";
+            for (char c : value) {
+                if (c == '"' || c == '\\')
+                    escaped += '\\';
+
+                escaped += c;
+            }
+            escaped += "\"";
+
+            m_values.emplace_back(key, escaped);
+        }
+
+        void add(const std::string& key, const char* value) {
+            add(key, std::string(value));
+        }
+
+        void add(const std::string& key, double value) {
+            char buffer[64] = {};
+            snprintf(buffer, sizeof(buffer), "%.3f", value);
+
+            m_values.emplace_back(key, buffer);
+        }
+
+        void add(const std::string& key, uint64_t value) {
+            m_values.emplace_back(key, std::to_string(value));
+        }
+
+        void add(const std::string& key, bool value) {
+            m_values.emplace_back(key, value ? "true" : "false");
+        }
+
+        void add(const std::string& key, const json_object& value) {
+            m_values.emplace_back(key, value.to_string());
+        }
+
+        void add(const std::string& key, const std::vector<json_object>& values) {
+            std::string array = "[";
+
+            for (size_t i = 0; i < values.size(); i++) {
+                if (i != 0)
+                    array += ",";
+
+                array += values[i].to_string();
+            }
+
+            array += "]";
+            m_values.emplace_back(key, array);
+        }
+
+        std::string to_string() const {
+            std::string result = "{";
+
+            for (size_t i = 0; i < m_values.size(); i++) {
+                if (i != 0)
+                    result += ",";
+
+                result += "\"" + m_values[i].first + "\":" + m_values[i].second;
+            }
+
+            result += "}";
+            return result;
+        }
+
+    private:
+        std::vector<std::pair<std::string, std::string>> m_values;
+    };
+
+    /*
+        Print JSON to stdout or save it to a file if path is set.
+    */
+    inline bool output_json(const json_object& json, const std::string& path) {
+        std::string str = json.to_string() + "\n";
+
+        if (path.empty()) {
+            std::cout << str;
+            return true;
+        }
+
+        std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+            return false;
+
+        stream << str;
+        return stream.good();
+    }
+
+    /*
+        Minimal --key value argument parser.
+    */
+    class args {
+    public:
+        args(int argc, char** argv) {
+            for (int i = 1; i < argc; i++) {
+                std::string key = argv[i];
+                if (key.rfind("--", 0) != 0)
+                    continue;
+
+                key.erase(0, 2);
+
+                if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0)
+                    m_values[key] = argv[++i];
+                else
+                    m_values[key] = "";
+            }
+        }
+
+    public:
+        bool has(const std::string& key) const {
+            return m_values.contains(key);
+        }
+
+        std::string get(const std::string& key, const std::string& def) const {
+            auto it = m_values.find(key);
+            return it != m_values.end() ? it->second : def;
+        }
+
+        uint64_t get(const std::string& key, uint64_t def) const {
+            auto it = m_values.find(key);
+            return it != m_values.end() ? std::strtoull(it->second.c_str(), nullptr, 10) : def;
+        }
+
+        double get(const std::string& key, double def) const {
+            auto it = m_values.find(key);
+            return it != m_values.end() ? std::strtod(it->second.c_str(), nullptr) : def;
+        }
+
+    private:
+        std::map<std::string, std::string> m_values;
+    };
+}
@@ -0,0 +1,404 @@
+/*
+    Kernel microbenchmarks.
+
+    Measures the hot loops of the readers in isolation: TEA decoding, MD5,
+    zlib block decompression at different chunk sizes, read callbacks and stream reads.
+    Results are printed as JSON, run with --help for options.
+*/
+
+#include "bench_common.hpp"
+
+#include "libevp/format/format_v2_kernels.hpp"
+#include "libevp/stream/stream_read.hpp"
+#include "libevp/misc/mapped_file.hpp"
+
+#include <md5/md5.hpp>
+#include <miniz/miniz.h>
+
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+// keeps results observable so loops aren't optimized away
+static volatile uint64_t g_sink = 0U;
+
+static void consume(uint64_t value) {
+    g_sink = g_sink + value;
+}
+
+struct kernel_result {
+    double   best_s = 0.0;
+    uint64_t bytes  = 0U;   // bytes processed per run
+    uint64_t ops    = 0U;   // operations per run
+};
+
+/*
+    Run kernel multiple times and keep the best run.
+*/
+static kernel_result run_kernel(uint32_t runs, uint64_t bytes, uint64_t ops, const std::function<void()>& kernel);
+
+/*
+    Describe kernel result.
+*/
+static bench::json_object to_json(const std::string& name, const kernel_result& result,
+    const std::vector<std::pair<std::string, uint64_t>>& params = {});
+
+/*
+    Fill buffer with half repetitive, half random data.
+*/
+static void fill_data(std::vector<uint8_t>& data);
+
+static void print_usage();
+
+///////////////////////////////////////////////////////////////////////////////
+// MAIN
+
+int main(int argc, char** argv) {
+    bench::args args(argc, argv);
+
+    if (args.has("help")) {
+        print_usage();
+        return 0;
+    }
+
+    uint64_t    size   = std::max<uint64_t>(1U, args.get("size", (uint64_t)64U)) * 1024U * 1024U;
+    uint32_t    runs   = (uint32_t)std::max<uint64_t>(1U, args.get("runs", (uint64_t)5U));
+    std::string filter = args.get("filter", std::string(""));
+
+    std::filesystem::path work_dir = args.get("work-dir",
+        (std::filesystem::temp_directory_path() / "libevp_bench_kernels").string());
+
+    std::error_code ec;
+    std::filesystem::create_directories(work_dir, ec);
+
+    auto enabled = [&](const std::string& name) {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    };
+
+    std::vector<uint8_t> data(size);
+    fill_data(data);
+
+    std::vector<bench::json_object> results;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // TEA
+
+    if (enabled("TEA_decode")) {
+        uint32_t key[4] = { 0x98DFF541, 0x2B4805C2, 0x01AF979B, 0xD8144BA5 };
+
+        std::vector<uint8_t> buffer(data.begin(), data.end());
+        uint64_t             blocks = buffer.size() / 8;
+
+        auto result = run_kernel(runs, blocks * 8, blocks, [&] {
+            for (uint64_t i = 0; i < blocks; i++)
+                format::v2::TEA_decode(buffer.data() + i * 8, buffer.data() + i * 8, key);
+
+            consume(buffer[0]);
+        });
+
+        results.push_back(to_json("TEA_decode", result));
+    }
+
+    if (enabled("decode_block")) {
+        std::vector<uint8_t> buffer(data.begin(), data.end());
+        uint64_t             blocks = buffer.size() / format::v2::ZLIB_IN_CHUNK_SIZE;
+
+        auto result = run_kernel(runs, blocks * format::v2::TEA_CHUNK_SIZE, blocks, [&] {
+            for (uint64_t i = 0; i < blocks; i++)
+                format::v2::decode_block(buffer.data() + i * format::v2::ZLIB_IN_CHUNK_SIZE, format::v2::ZLIB_IN_CHUNK_SIZE);
+
+            consume(buffer[0]);
+        });
+
+        results.push_back(to_json("decode_block", result));
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // MD5
+
+    if (enabled("MD5_add")) {
+        for (uint64_t chunk : { 4096U, 16384U, 65536U, 1048576U }) {
+            auto result = run_kernel(runs, data.size(), data.size() / chunk, [&] {
+                MD5 md5;
+
+                for (uint64_t pos = 0; pos < data.size(); pos += chunk)
+                    md5.add(data.data() + pos, std::min<uint64_t>(chunk, data.size() - pos));
+
+                consume(md5.getHash()[0]);
+            });
+
+            results.push_back(to_json("MD5_add", result, { { "chunk_size", chunk } }));
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // ZLIB
+
+    if (enabled("zlib_decompress_block")) {
+        mz_ulong             compressed_size = mz_compressBound((mz_ulong)data.size());
+        std::vector<uint8_t> compressed(compressed_size);
+
+        mz_compress2(compressed.data(), &compressed_size, data.data(), (mz_ulong)data.size(), MZ_DEFAULT_LEVEL);
+        compressed.resize(compressed_size);
+
+        for (uint32_t in_chunk : { 4096U, 16384U, 65536U, 262144U }) {
+            for (uint32_t out_chunk : { 16384U, 65536U, 262144U }) {
+                std::vector<uint8_t> out(out_chunk);
+                uint64_t             total = 0U;
+
+                auto cb = [&](const uint8_t*, uint32_t size) {
+                    total += size;
+                };
+
+                auto result = run_kernel(runs, data.size(), (compressed.size() + in_chunk - 1) / in_chunk, [&] {
+                    mz_stream stream{};
+                    mz_inflateInit(&stream);
+
+                    for (size_t pos = 0; pos < compressed.size(); pos += in_chunk) {
+                        uint32_t count = (uint32_t)std::min<size_t>(in_chunk, compressed.size() - pos);
+
+                        int res = format::v2::zlib_decompress_block(stream, compressed.data() + pos, count,
+                            out.data(), out_chunk, cb);
+
+                        if (res == MZ_STREAM_END) break;
+                    }
+
+                    mz_inflateEnd(&stream);
+                    consume(total);
+                });
+
+                results.push_back(to_json("zlib_decompress_block", result,
+                    { { "in_chunk_size", in_chunk }, { "out_chunk_size", out_chunk } }));
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CALLBACK
+
+    if (enabled("callback_std_function") || enabled("callback_direct")) {
+        constexpr uint64_t CALLS = 10000000U;
+        uint64_t           total = 0U;
+
+        format::format::data_read_cb_t cb = [&](const uint8_t*, uint32_t size) {
+            total += size;
+        };
+
+        auto function_result = run_kernel(runs, 0U, CALLS, [&] {
+            for (uint64_t i = 0; i < CALLS; i++)
+                cb(data.data(), (uint32_t)i);
+
+            consume(total);
+        });
+
+        results.push_back(to_json("callback_std_function", function_result));
+
+        auto direct = [&](const uint8_t*, uint32_t size) {
+            total += size;
+        };
+
+        auto direct_result = run_kernel(runs, 0U, CALLS, [&] {
+            for (uint64_t i = 0; i < CALLS; i++)
+                direct(data.data(), (uint32_t)i);
+
+            consume(total);
+        });
+
+        results.push_back(to_json("callback_direct", direct_result));
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STREAM READS
+
+    if (enabled("fstream_read_u32") || enabled("buffered_read_u32") || enabled("mapped_read_u32") ||
+        enabled("fstream_read_chunk") || enabled("mapped_read_chunk"))
+    {
+        std::filesystem::path file = work_dir / "read.bin";
+
+        {
+            std::ofstream stream(file, std::ios::out | std::ios::binary | std::ios::trunc);
+            stream.write((const char*)data.data(), data.size());
+        }
+
+        uint64_t values = data.size() / sizeof(uint32_t);
+
+        if (enabled("fstream_read_u32")) {
+            auto result = run_kernel(runs, values * sizeof(uint32_t), values, [&] {
+                fstream_read stream(file);
+                uint64_t     sum = 0U;
+
+                for (uint64_t i = 0; i < values; i++)
+                    sum += stream.read<uint32_t>();
+
+                consume(sum);
+            });
+
+            results.push_back(to_json("fstream_read_u32", result));
+        }
+
+        if (enabled("buffered_read_u32")) {
+            auto result = run_kernel(runs, values * sizeof(uint32_t), values, [&] {
+                std::vector<uint8_t> buffer(data.size());
+
+                {
+                    fstream_read file_stream(file);
+                    file_stream.read(buffer.data(), (uint32_t)buffer.size());
+                }
+
+                stream_read stream(buffer);
+                uint64_t    sum = 0U;
+
+                for (uint64_t i = 0; i < values; i++)
+                    sum += stream.read<uint32_t>();
+
+                consume(sum);
+            });
+
+            results.push_back(to_json("buffered_read_u32", result));
+        }
+
+        if (enabled("mapped_read_u32")) {
+            auto result = run_kernel(runs, values * sizeof(uint32_t), values, [&] {
+                mapped_file mapped(file);
+                uint64_t    sum = 0U;
+
+                for (uint64_t i = 0; i < values; i++) {
+                    uint32_t value;
+                    memcpy(&value, mapped.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+                    sum += value;
+                }
+
+                consume(sum);
+            });
+
+            results.push_back(to_json("mapped_read_u32", result));
+        }
+
+        for (uint32_t chunk : { 4096U, 16384U, 65536U, 1048576U }) {
+            std::vector<uint8_t> buffer(chunk);
+
+            if (enabled("fstream_read_chunk")) {
+                auto result = run_kernel(runs, data.size(), (data.size() + chunk - 1) / chunk, [&] {
+                    fstream_read stream(file);
+
+                    for (uint64_t pos = 0; pos < data.size(); pos += chunk)
+                        stream.read(buffer.data(), (uint32_t)std::min<uint64_t>(chunk, data.size() - pos));
+
+                    consume(buffer[0]);
+                });
+
+                results.push_back(to_json("fstream_read_chunk", result, { { "chunk_size", chunk } }));
+            }
+
+            if (enabled("mapped_read_chunk")) {
+                auto result = run_kernel(runs, data.size(), (data.size() + chunk - 1) / chunk, [&] {
+                    mapped_file mapped(file);
+
+                    for (uint64_t pos = 0; pos < data.size(); pos += chunk)
+                        memcpy(buffer.data(), mapped.data() + pos, std::min<uint64_t>(chunk, data.size() - pos));
+
+                    consume(buffer[0]);
+                });
+
+                results.push_back(to_json("mapped_read_chunk", result, { { "chunk_size", chunk } }));
+            }
+        }
+
+        std::filesystem::remove(file, ec);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // OUTPUT
+
+    bench::json_object json_config;
+    json_config.add("size",                size);
+    json_config.add("runs",                (uint64_t)runs);
+    json_config.add("read_chunk_size",     (uint64_t)EVP_READ_CHUNK_SIZE);
+    json_config.add("zlib_in_chunk_size",  (uint64_t)format::v2::ZLIB_IN_CHUNK_SIZE);
+    json_config.add("zlib_out_chunk_size", (uint64_t)format::v2::ZLIB_OUT_CHUNK_SIZE);
+
+    bench::json_object json;
+    json.add("benchmark",   "kernels");
+    json.add("config",      json_config);
+    json.add("results",     results);
+    json.add("peak_rss_kb", bench::get_peak_rss_kb());
+
+    if (!bench::output_json(json, args.get("output", std::string("")))) {
+        fprintf(stderr, "Failed to write output.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+kernel_result run_kernel(uint32_t runs, uint64_t bytes, uint64_t ops, const std::function<void()>& kernel) {
+    kernel_result result;
+    result.bytes = bytes;
+    result.ops   = ops;
+
+    for (uint32_t i = 0; i < runs; i++) {
+        bench::timer timer;
+        kernel();
+
+        double elapsed = timer.elapsed_s();
+        result.best_s  = i == 0 ? elapsed : std::min(result.best_s, elapsed);
+    }
+
+    return result;
+}
+
+bench::json_object to_json(const std::string& name, const kernel_result& result,
+    const std::vector<std::pair<std::string, uint64_t>>& params)
+{
+    bench::json_object json;
+    json.add("name", name);
+
+    for (const auto& [key, value] : params)
+        json.add(key, value);
+
+    json.add("best_s", result.best_s);
+
+    if (result.best_s > 0.0) {
+        if (result.bytes)
+            json.add("mb_s", (double)result.bytes / (1024.0 * 1024.0) / result.best_s);
+
+        if (result.ops)
+            json.add("ns_per_op", result.best_s * 1e9 / (double)result.ops);
+    }
+
+    return json;
+}
+
+void fill_data(std::vector<uint8_t>& data) {
+    constexpr char PHRASE[] = "The quick brown fox jumps over the lazy dog. ";
+
+    std::mt19937_64 rng(1U);
+
+    for (size_t pos = 0; pos < data.size(); pos += 64) {
+        size_t run        = std::min<size_t>(64, data.size() - pos);
+        bool   repetitive = rng() & 1;
+
+        for (size_t i = 0; i < run; i++) {
+            data[pos + i] = repetitive ? (uint8_t)PHRASE[(pos + i) % (sizeof(PHRASE) - 1)] : (uint8_t)rng();
+        }
+    }
+}
+
+void print_usage() {
+    fprintf(stderr,
+        "usage: bench_kernels [options]\n"
+        "  --size N          input size in MiB (default 64)\n"
+        "  --runs N          runs per kernel, best is reported (default 5)\n"
+        "  --filter NAME     only run kernels whose name contains NAME\n"
+        "  --work-dir PATH   scratch directory for read kernels (default temp)\n"
+        "  --output PATH     write JSON to file instead of stdout\n");
+}
@@ -1,3 +1,6 @@
 #pragma once
 
 #include <libevp/evp.hpp>
+#include <libevp/evp_vfs.hpp>
+#include <libevp/evp_index.hpp>
+#include <libevp/evp_hash_cache.hpp>
@@ -2,10 +2,18 @@
 
 #include <libevp/evp_defs.hpp>
 #include <libevp/evp_context.hpp>
+#include <libevp/evp_cache.hpp>
+#include <libevp/evp_job.hpp>
+#include <libevp/evp_thread_pool.hpp>
+#include <libevp/evp_source.hpp>
+#include <libevp/evp_sink.hpp>
+#include <libevp/evp_hash_cache.hpp>
 #include <libevp/model/evp_fd.hpp>
 #include <libevp/model/evp_result.hpp>
+#include <libevp/model/evp_access_record.hpp>
 
 #include <vector>
+#include <optional>
 
 namespace libevp {
     class evp {
@@ -13,11 +21,97 @@ namespace libevp {
         struct pack_input {
             DIR_PATH              base;
             std::vector<DIR_PATH> files;
+
+            // reserve disk space for the expected archive size before writing
+            bool preallocate = true;
+
+            // reuse hashes of unchanged files, updated with hashes of packed files
+            std::shared_ptr<evp_hash_cache> hash_cache;
+
+            // archive unchanged files are copied from, e.g. last build of the same files
+            FILE_PATH previous_archive;
+
+            // entries in the order clients read them, see pack_source_input::access_trace
+            std::vector<evp_access_record> access_trace;
+
+            // see pack_source_input::alignment
+            uint32_t alignment           = 0U;
+            uint64_t alignment_threshold = 0U;
+        };
+
+        struct pack_entry {
+            std::string       file;     // path inside archive
+            evp_source::ptr_t source;   // entry data, read front to back once
+
+            // known MD5 of entry data, entries from files are then copied without reading them
+            std::optional<std::array<uint8_t, 16>> hash;
+        };
+
+        struct pack_source_input {
+            std::vector<pack_entry> entries;
+
+            // reserve space for the expected archive size before writing
+            bool preallocate = true;
+
+            /*
+                Entries in the order clients read them, e.g. from evp_trace::get_access_records().
+                If set, traced entries are laid out first in order of first access (by time if known)
+                and the rest follow grouped by directory. Entries keep input order if empty.
+            */
+            std::vector<evp_access_record> access_trace;
+
+            /*
+                Boundary data of entries at least alignment_threshold bytes large starts at,
+                e.g. 4 KiB or 2 MiB so entries can be mapped or read with O_DIRECT on their own.
+                Must be a power of two, 0 packs entries back to back. Readers skip the padding.
+            */
+            uint32_t alignment           = 0U;
+            uint64_t alignment_threshold = 0U;
         };
 
         struct unpack_input {
             FILE_PATH           archive;
             std::vector<evp_fd> files;
+
+            // copy stored entries inside the kernel where supported
+            bool zero_copy = true;
+        };
+
+        struct transcode_input {
+            evp_source::ptr_t archive;
+
+            // hash decoded data instead of carrying hashes across
+            bool recompute_hashes = false;
+
+            // reserve space for the expected archive size before writing
+            bool preallocate = true;
+        };
+
+        enum class validate_tier : uint8_t {
+            structural = 0x0,   // header, descriptor and entry range sanity, no entry data is read
+            quick      = 0x1,   // structural, compressed stream headers and a sample of entries hashed
+            full       = 0x2    // structural and every entry inside the archive decoded and hashed, even with structural issues
+        };
+
+        struct validate_input {
+            validate_tier tier = validate_tier::full;
+
+            // entries hashed by the quick tier, spread evenly over the archive
+            uint32_t sample_count = 8U;
+        };
+
+        struct validate_issue {
+            enum class type : uint8_t {
+                out_of_bounds = 0x0,    // data reaches past archive end or into the descriptor block
+                overlap       = 0x1,    // data partially overlaps another entry
+                duplicate     = 0x2,    // data range is the same as another entry's
+                corrupt       = 0x3,    // data failed to decode
+                hash_mismatch = 0x4     // decoded data doesn't match stored hash
+            };
+
+            evp_fd               fd      = {};
+            validate_issue::type kind    = validate_issue::type::corrupt;
+            std::string          message = "";
         };
 
     public:
@@ -30,6 +124,36 @@ namespace libevp {
 
     public:
 
+        /*
+         *  Set cache used to store decoded files.
+         *
+         *  @param cache    -> cache to use, nullptr to disable caching
+        */
+        LIBEVP_API void set_cache(std::shared_ptr<evp_cache> cache);
+
+        /*
+         *  Get cache used to store decoded files.
+         *
+         *  @returns std::shared_ptr<evp_cache>
+         *      cache if set, nullptr otherwise;
+        */
+        LIBEVP_API std::shared_ptr<evp_cache> get_cache() const;
+
+        /*
+         *  Set thread pool used by async operations.
+         *
+         *  @param pool     -> pool to use, nullptr to use the global pool
+        */
+        LIBEVP_API void set_thread_pool(std::shared_ptr<evp_thread_pool> pool);
+
+        /*
+         *  Get thread pool used by async operations.
+         *
+         *  @returns std::shared_ptr<evp_thread_pool>
+         *      set pool or the global pool;
+        */
+        LIBEVP_API std::shared_ptr<evp_thread_pool> get_thread_pool() const;
+
         /*
          *  Pack files in dir into an archive.
          *
@@ -42,6 +166,19 @@ namespace libevp {
         */
         LIBEVP_API evp_result pack(const pack_input& input, const FILE_PATH& output);
 
+        /*
+         *  Pack entries into an archive.
+         *  Entry data can come from any source, e.g. memory buffers or callbacks.
+         *
+         *  @param input    -> entries to pack
+         *  @param output   -> sink to write the archive into
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         packed successfully;
+         *      status == evp_result_status::failure    an error occurred during packing, message contains details;
+        */
+        LIBEVP_API evp_result pack(const pack_source_input& input, const evp_sink::ptr_t& output);
+
         /*
          *  Unpack archive contents into a dir.
          *
@@ -54,35 +191,114 @@ namespace libevp {
         */
         LIBEVP_API evp_result unpack(const unpack_input& input, const DIR_PATH& output);
 
+        /*
+         *  Convert archive of any supported format into format v1.
+         *  Entries are streamed from input to output, nothing is extracted.
+         *  Descriptors are carried across, format v1 entries are copied as is.
+         *
+         *  @param input    -> archive to convert and options
+         *  @param output   -> sink to write the converted archive into
+         *  @param context  -> optional, only cancel token, progress callback, stats and trace are used
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         converted successfully;
+         *      status == evp_result_status::failure    an error occurred, message contains details;
+         *      status == evp_result_status::cancelled  cancelled through context;
+        */
+        LIBEVP_API evp_result transcode(const transcode_input& input, const evp_sink::ptr_t& output,
+            evp_context* context = nullptr);
+
         /*
          *  Asynchronously pack files in dir into an archive.
+         *  Runs on the thread pool, subject to the global I/O limit.
          *
          *  @param input    -> files to pack
          *  @param output   -> file path where to save the created .evp archive
          *  @param context  -> pointer to context that has callbacks
+         *
+         *  @returns evp_job
+         *      handle to wait on, poll or cancel the job;
         */
-        LIBEVP_API void pack_async(const pack_input& input, const FILE_PATH& output, evp_context* context = nullptr);
+        LIBEVP_API evp_job pack_async(const pack_input& input, const FILE_PATH& output, evp_context* context = nullptr);
 
         /*
          *  Asynchronously unpack archive contents into a dir.
+         *  Runs on the thread pool, subject to the global I/O limit.
          *
          *  @param input    -> archive and optional files
          *  @param output   -> dir path where to save unpacked files
          *  @param context  -> pointer to context that has callbacks
+         *
+         *  @returns evp_job
+         *      handle to wait on, poll or cancel the job;
         */
-        LIBEVP_API void unpack_async(const unpack_input& input, const DIR_PATH& output, evp_context* context = nullptr);
+        LIBEVP_API evp_job unpack_async(const unpack_input& input, const DIR_PATH& output, evp_context* context = nullptr);
 
         /*
          *  Validate files packed inside archive.
          *
          *  @param input    -> file path to archive
          *  @param files    -> vector to store file fds that failed to validate
+         *  @param context  -> optional, only cancel token, progress callback and stats are used
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         all files successfully validated;
+         *      status == evp_result_status::failure    an error occurred, message contains details;
+         *      status == evp_result_status::cancelled  cancelled through context;
+        */
+        LIBEVP_API evp_result validate_files(const FILE_PATH& input, std::vector<evp_fd>* failed_files = nullptr,
+            evp_context* context = nullptr);
+
+        /*
+         *  Validate files packed inside archive.
+         *
+         *  @param input    -> archive source
+         *  @param files    -> vector to store file fds that failed to validate
+         *  @param context  -> optional, only cancel token, progress callback and stats are used
          *
          *  @returns evp_result
          *      status == evp_result_status::ok         all files successfully validated;
          *      status == evp_result_status::failure    an error occurred, message contains details;
+         *      status == evp_result_status::cancelled  cancelled through context;
         */
-        LIBEVP_API evp_result validate_files(const FILE_PATH& input, std::vector<evp_fd>* failed_files = nullptr);
+        LIBEVP_API evp_result validate_files(const evp_source::ptr_t& input, std::vector<evp_fd>* failed_files = nullptr,
+            evp_context* context = nullptr);
+
+        /*
+         *  Validate archive up to a tier.
+         *  Tiers build on each other. Quick tier doesn't read data if the structural tier finds issues,
+         *  full tier still hashes every entry inside the archive and reports issues of both.
+         *
+         *  @param input    -> file path to archive
+         *  @param options  -> tier to validate up to
+         *  @param issues   -> vector to store per entry issues
+         *  @param context  -> optional, only cancel token, progress callback and stats are used
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         no issues found;
+         *      status == evp_result_status::failure    issues found or an error occurred, message contains details;
+         *      status == evp_result_status::cancelled  cancelled through context;
+        */
+        LIBEVP_API evp_result validate(const FILE_PATH& input, const validate_input& options,
+            std::vector<validate_issue>* issues = nullptr, evp_context* context = nullptr);
+
+        /*
+         *  Validate archive up to a tier.
+         *  Tiers build on each other. Quick tier doesn't read data if the structural tier finds issues,
+         *  full tier still hashes every entry inside the archive and reports issues of both.
+         *
+         *  @param input    -> archive source
+         *  @param options  -> tier to validate up to
+         *  @param issues   -> vector to store per entry issues
+         *  @param context  -> optional, only cancel token, progress callback and stats are used
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         no issues found;
+         *      status == evp_result_status::failure    issues found or an error occurred, message contains details;
+         *      status == evp_result_status::cancelled  cancelled through context;
+        */
+        LIBEVP_API evp_result validate(const evp_source::ptr_t& input, const validate_input& options,
+            std::vector<validate_issue>* issues = nullptr, evp_context* context = nullptr);
 
         /*
          *  Get file fds packed inside archive.
@@ -96,6 +312,18 @@ namespace libevp {
         */
         LIBEVP_API evp_result get_archive_fds(const FILE_PATH& input, std::vector<evp_fd>& files);
 
+        /*
+         *  Get file fds packed inside archive.
+         *
+         *  @param input    -> archive source
+         *  @param files    -> vector to store the file fds into
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         got files successfully;
+         *      status == evp_result_status::failure    an error occurred, message contains details;
+        */
+        LIBEVP_API evp_result get_archive_fds(const evp_source::ptr_t& input, std::vector<evp_fd>& files);
+
         /*
          *  Unpack a single file from archive into a buffer.
          *
@@ -122,8 +350,23 @@ namespace libevp {
         */
         LIBEVP_API evp_result get_file(const FILE_PATH& input, const evp_fd& file, std::stringstream& stream);
 
+        /*
+         *  Unpack a single file from archive into a shared immutable buffer.
+         *  If a cache is set, the buffer is served from and stored in it.
+         *
+         *  @param input    -> file path to archive
+         *  @param file     -> file fd to unpack
+         *  @param buffer   -> shared buffer to unpack into
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         unpacked successfully;
+         *      status == evp_result_status::failure    an error occurred during unpacking, message contains details;
+        */
+        LIBEVP_API evp_result get_file(const FILE_PATH& input, const evp_fd& file, evp_cache::buffer_ptr_t& buffer);
+
         /*
          *  Unpack a single file from archive into a buffer.
+         *  If a cache is set, the file is looked up by name before the archive is read.
          *
          *  @param input    -> file path to archive
          *  @param file     -> file to unpack
@@ -135,6 +378,22 @@ namespace libevp {
         */
         LIBEVP_API evp_result get_file(const FILE_PATH& input, const FILE_PATH& file, std::vector<uint8_t>& buffer);
 
+        /*
+         *  Unpack multiple files from archive into shared immutable buffers.
+         *  Archive is opened once for all files.
+         *  If a cache is set, buffers are served from and stored in it.
+         *
+         *  @param input    -> file path to archive
+         *  @param files    -> file fds to unpack
+         *  @param buffers  -> buffers to unpack into, same order as files
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         unpacked successfully;
+         *      status == evp_result_status::failure    an error occurred during unpacking, message contains details;
+        */
+        LIBEVP_API evp_result get_files(const FILE_PATH& input, const std::vector<evp_fd>& files,
+            std::vector<evp_cache::buffer_ptr_t>& buffers);
+
         /*
          *  Unpack a single file from archive into a stringstream.
          *
@@ -147,5 +406,37 @@ namespace libevp {
          *      status == evp_result_status::failure    an error occurred during unpacking, message contains details;
         */
         LIBEVP_API evp_result get_file(const FILE_PATH& input, const FILE_PATH& file, std::stringstream& stream);
+
+        /*
+         *  Unpack a single file from archive source into a buffer.
+         *  Cache is not used.
+         *
+         *  @param input    -> archive source
+         *  @param file     -> file fd to unpack
+         *  @param buffer   -> buffer to unpack into
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         unpacked successfully;
+         *      status == evp_result_status::failure    an error occurred during unpacking, message contains details;
+        */
+        LIBEVP_API evp_result get_file(const evp_source::ptr_t& input, const evp_fd& file, std::vector<uint8_t>& buffer);
+
+        /*
+         *  Unpack a single file from archive source into a buffer.
+         *  Cache is not used.
+         *
+         *  @param input    -> archive source
+         *  @param file     -> file to unpack
+         *  @param buffer   -> buffer to unpack into
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         unpacked successfully;
+         *      status == evp_result_status::failure    an error occurred during unpacking, message contains details;
+        */
+        LIBEVP_API evp_result get_file(const evp_source::ptr_t& input, const FILE_PATH& file, std::vector<uint8_t>& buffer);
+
+    private:
+        std::shared_ptr<evp_cache>       m_cache;
+        std::shared_ptr<evp_thread_pool> m_pool;
     };
 }
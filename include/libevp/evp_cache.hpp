@@ -0,0 +1,151 @@
+#pragma once
+
+#include <libevp/evp_defs.hpp>
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+namespace libevp {
+    /*
+        evp cache object
+
+        Holds decoded file data keyed by archive identity and entry offset,
+        optionally also reachable by entry name.
+        Least recently used entries are evicted once the byte budget is exceeded.
+        Cached buffers are immutable and can be shared between readers.
+    */
+    class evp_cache {
+    public:
+        using buffer_ptr_t = std::shared_ptr<const std::vector<uint8_t>>;
+
+        struct stats {
+            uint64_t hits      = 0U;
+            uint64_t misses    = 0U;
+            uint64_t evictions = 0U;
+            uint64_t entries   = 0U;
+            uint64_t size      = 0U;
+            uint64_t budget    = 0U;
+        };
+
+    public:
+        evp_cache()                 = delete;
+        evp_cache(const evp_cache&) = delete;
+        evp_cache(evp_cache&&)      = delete;
+
+        /*
+         *  @param budget   -> max sum of cached buffer sizes in bytes
+        */
+        LIBEVP_API evp_cache(uint64_t budget);
+
+        evp_cache& operator=(const evp_cache&) = delete;
+        evp_cache& operator=(evp_cache&&)      = delete;
+
+    public:
+
+        /*
+         *  Get cached buffer.
+         *
+         *  @param archive  -> archive identity
+         *  @param offset   -> entry data offset
+         *
+         *  @returns buffer_ptr_t
+         *      cached buffer if found, nullptr otherwise;
+        */
+        LIBEVP_API buffer_ptr_t get(const std::string& archive, uint64_t offset);
+
+        /*
+         *  Get cached buffer by entry name.
+         *
+         *  @param archive  -> archive identity
+         *  @param file     -> entry name, '/' separated
+         *
+         *  @returns buffer_ptr_t
+         *      cached buffer if it was stored with this name, nullptr otherwise;
+        */
+        LIBEVP_API buffer_ptr_t get(const std::string& archive, const std::string& file);
+
+        /*
+         *  Store buffer in cache.
+         *  Buffers larger than the budget are not stored.
+         *
+         *  @param archive  -> archive identity
+         *  @param offset   -> entry data offset
+         *  @param buffer   -> decoded data
+         *  @param file     -> entry name to make the buffer reachable by, empty for none
+        */
+        LIBEVP_API void put(const std::string& archive, uint64_t offset, buffer_ptr_t buffer,
+            const std::string& file = "");
+
+        /*
+         *  Remove all cached buffers.
+        */
+        LIBEVP_API void clear();
+
+        /*
+         *  Change byte budget, evicting buffers if needed.
+         *
+         *  @param budget   -> max sum of cached buffer sizes in bytes
+        */
+        LIBEVP_API void set_budget(uint64_t budget);
+
+        /*
+         *  Get hit/miss counters and current usage.
+        */
+        LIBEVP_API stats get_stats() const;
+
+    private:
+        struct key {
+            std::string archive = "";
+            uint64_t    offset  = 0U;
+
+            bool operator==(const key& other) const {
+                return offset == other.offset && archive == other.archive;
+            }
+        };
+
+        struct key_hash {
+            size_t operator()(const key& k) const {
+                return std::hash<std::string>()(k.archive) ^ (std::hash<uint64_t>()(k.offset) << 1);
+            }
+        };
+
+        struct name_key {
+            std::string archive = "";
+            std::string file    = "";
+
+            bool operator==(const name_key& other) const {
+                return file == other.file && archive == other.archive;
+            }
+        };
+
+        struct name_key_hash {
+            size_t operator()(const name_key& k) const {
+                return std::hash<std::string>()(k.archive) ^ (std::hash<std::string>()(k.file) << 1);
+            }
+        };
+
+        struct entry {
+            key                      id     = {};
+            buffer_ptr_t             buffer = nullptr;
+            std::vector<std::string> names  = {};
+        };
+
+        using lru_t = std::list<entry>;
+
+    private:
+        mutable std::mutex                                           m_mutex;
+        lru_t                                                        m_lru;
+        std::unordered_map<key, lru_t::iterator, key_hash>           m_map;
+        std::unordered_map<name_key, lru_t::iterator, name_key_hash> m_names;
+        stats                                                        m_stats;
+
+    private:
+        void evict();
+        void erase(lru_t::iterator it);
+    };
+}
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <libevp/evp_stats.hpp>
+#include <libevp/evp_trace.hpp>
 #include <libevp/model/evp_result.hpp>
 
 #include <functional>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 
 namespace libevp {
     /*
@@ -12,9 +16,10 @@ namespace libevp {
         Contains user bound callbacks and work cancelling.
     */
     struct evp_context {
-        using start_callback_t  = std::function<void()>;
-        using finish_callback_t = std::function<void(evp_result)>;
-        using update_callback_t = std::function<void(float)>;
+        using start_callback_t    = std::function<void()>;
+        using finish_callback_t   = std::function<void(evp_result)>;
+        using update_callback_t   = std::function<void(float)>;
+        using progress_callback_t = std::function<void(uint64_t, uint64_t)>;
 
         /*
             Start callback.
@@ -37,9 +42,33 @@ namespace libevp {
         */
         update_callback_t update_callback = nullptr;
 
+        /*
+            Progress callback.
+            Reports bytes processed out of total bytes known up front,
+            invoked at most once per progress_interval and once at the end.
+
+            @param void(uint64_t, uint64_t) -> processed bytes, total bytes
+        */
+        progress_callback_t progress_callback = nullptr;
+
+        /*
+            Min time between progress callback invocations.
+        */
+        std::chrono::milliseconds progress_interval = std::chrono::milliseconds(100);
+
         /*
             Cancel token.
         */
         std::atomic_bool* cancel = nullptr;
+
+        /*
+            Optional stats, filled in while the operation runs.
+        */
+        evp_stats* stats = nullptr;
+
+        /*
+            Optional trace, spans are recorded while the operation runs.
+        */
+        evp_trace* trace = nullptr;
     };
 }
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <libevp/evp.hpp>
+#include <libevp/evp_index.hpp>
+#include <libevp/evp_thread_pool.hpp>
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <coroutine>
+#include <functional>
+
+namespace libevp {
+    /*
+        Executor used to resume awaiting coroutines.
+        Receives a callable that has to be run on the caller's executor (e.g. posted to an event loop).
+    */
+    using evp_executor_t = std::function<void(std::function<void()>)>;
+
+    /*
+        Awaitable evp operation.
+
+        Work runs on a thread pool worker, the awaiting coroutine is resumed through
+        the executor, or directly on the worker if no executor is set.
+    */
+    class evp_awaitable {
+    public:
+        using work_t = std::function<evp_result()>;
+
+    public:
+        evp_awaitable(std::shared_ptr<evp_thread_pool> pool, evp_executor_t executor, work_t work)
+            : m_pool(std::move(pool)), m_executor(std::move(executor)), m_work(std::move(work)) {}
+
+    public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            m_pool->post_io([this, handle] {
+                try {
+                    m_value = m_work();
+                }
+                catch (const std::exception& e) {
+                    m_value.status  = evp_result::status::failure;
+                    m_value.message = e.what();
+                }
+
+                // resuming can destroy this awaitable, don't touch members after handing off
+                evp_executor_t executor = std::move(m_executor);
+
+                if (executor)
+                    executor([handle] { handle.resume(); });
+                else
+                    handle.resume();
+            });
+        }
+
+        evp_result await_resume() {
+            return std::move(m_value);
+        }
+
+    private:
+        std::shared_ptr<evp_thread_pool> m_pool;
+        evp_executor_t                   m_executor;
+        work_t                           m_work;
+        evp_result                       m_value = {};
+    };
+
+    /*
+        evp coroutine interface
+
+        Awaitable versions of archive operations.
+        Referenced evp and out parameters have to outlive the awaited operation.
+    */
+    class evp_coro {
+    public:
+        evp_coro() = delete;
+
+        /*
+         *  @param evp      -> evp instance whose thread pool and cache are used
+         *  @param executor -> executor to resume on, nullptr to resume on the worker
+        */
+        evp_coro(evp& evp, evp_executor_t executor = nullptr)
+            : m_evp(evp), m_executor(std::move(executor)) {}
+
+    public:
+
+        /*
+         *  Open archive index, see evp_index::open.
+        */
+        evp_awaitable open(const FILE_PATH& archive, evp_index& index, const FILE_PATH& index_path = "") {
+            return make([archive, &index, index_path] {
+                return index.open(archive, index_path);
+            });
+        }
+
+        /*
+         *  Unpack a single file, see evp::get_file.
+        */
+        evp_awaitable get_file(const FILE_PATH& input, const evp_fd& file, evp_cache::buffer_ptr_t& buffer) {
+            return make([this, input, file, &buffer] {
+                return m_evp.get_file(input, file, buffer);
+            });
+        }
+
+        /*
+         *  Unpack a single file, see evp::get_file.
+        */
+        evp_awaitable get_file(const FILE_PATH& input, const FILE_PATH& file, std::vector<uint8_t>& buffer) {
+            return make([this, input, file, &buffer] {
+                return m_evp.get_file(input, file, buffer);
+            });
+        }
+
+        /*
+         *  Unpack multiple files, see evp::get_files.
+        */
+        evp_awaitable get_files(const FILE_PATH& input, const std::vector<evp_fd>& files,
+            std::vector<evp_cache::buffer_ptr_t>& buffers)
+        {
+            return make([this, input, files, &buffers] {
+                return m_evp.get_files(input, files, buffers);
+            });
+        }
+
+        /*
+         *  Unpack archive contents into a dir, see evp::unpack.
+        */
+        evp_awaitable unpack(const evp::unpack_input& input, const DIR_PATH& output) {
+            return make([this, input, output] {
+                return m_evp.unpack(input, output);
+            });
+        }
+
+        /*
+         *  Validate files packed inside archive, see evp::validate_files.
+        */
+        evp_awaitable validate_files(const FILE_PATH& input, std::vector<evp_fd>* failed_files = nullptr) {
+            return make([this, input, failed_files] {
+                return m_evp.validate_files(input, failed_files);
+            });
+        }
+
+    private:
+        evp&           m_evp;
+        evp_executor_t m_executor;
+
+    private:
+        evp_awaitable make(evp_awaitable::work_t work) {
+            return evp_awaitable(m_evp.get_thread_pool(), m_executor, std::move(work));
+        }
+    };
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <libevp/evp_defs.hpp>
+#include <libevp/model/evp_result.hpp>
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+namespace libevp {
+    /*
+        evp hash cache object
+
+        MD5 hashes of packed files keyed by path, size, mtime and inode,
+        persisted between runs so unchanged files don't have to be hashed again.
+    */
+    class evp_hash_cache {
+    public:
+        using hash_t = std::array<uint8_t, 16>;
+
+        /*
+            File state a hash is valid for.
+        */
+        struct stamp {
+            uint64_t size  = 0U;
+            int64_t  mtime = 0;
+            uint64_t inode = 0U;
+        };
+
+    public:
+        evp_hash_cache(const evp_hash_cache&) = delete;
+        evp_hash_cache(evp_hash_cache&&)      = delete;
+
+        LIBEVP_API evp_hash_cache() = default;
+
+        evp_hash_cache& operator=(const evp_hash_cache&) = delete;
+        evp_hash_cache& operator=(evp_hash_cache&&)      = delete;
+
+    public:
+
+        /*
+         *  Read current state of a file.
+         *
+         *  @param file     -> file path
+         *  @param stamp    -> where to save the state
+         *
+         *  @returns bool
+         *      true if state was read;
+        */
+        LIBEVP_API static bool read_stamp(const FILE_PATH& file, stamp& stamp);
+
+        /*
+         *  Load cache file, replacing held hashes.
+         *
+         *  @param file     -> file path to cache
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         loaded successfully;
+         *      status == evp_result_status::failure    missing or invalid cache, message contains details;
+        */
+        LIBEVP_API evp_result load(const FILE_PATH& file);
+
+        /*
+         *  Save held hashes to cache file.
+         *
+         *  @param file     -> file path to cache
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         saved successfully;
+         *      status == evp_result_status::failure    an error occurred, message contains details;
+        */
+        LIBEVP_API evp_result save(const FILE_PATH& file) const;
+
+        /*
+         *  Get hash of a file if it was stored for the same file state.
+         *
+         *  @param file     -> file path
+         *  @param stamp    -> current file state
+         *  @param hash     -> where to save the hash
+         *
+         *  @returns bool
+         *      true if hash was found;
+        */
+        LIBEVP_API bool get(const FILE_PATH& file, const stamp& stamp, hash_t& hash) const;
+
+        /*
+         *  Store hash of a file.
+         *
+         *  @param file     -> file path
+         *  @param stamp    -> file state the hash was computed for
+         *  @param hash     -> file hash
+        */
+        LIBEVP_API void set(const FILE_PATH& file, const stamp& stamp, const hash_t& hash);
+
+        /*
+         *  Get number of held hashes.
+        */
+        LIBEVP_API size_t size() const;
+
+        /*
+         *  Remove all held hashes.
+        */
+        LIBEVP_API void clear();
+
+    private:
+        struct record {
+            stamp  state = {};
+            hash_t hash  = {};
+        };
+
+    private:
+        mutable std::mutex                      m_mutex;
+        std::unordered_map<std::string, record> m_records;
+
+    private:
+        static std::string get_key(const FILE_PATH& file);
+    };
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <libevp/evp_defs.hpp>
+#include <libevp/model/evp_fd.hpp>
+#include <libevp/model/evp_fd_view.hpp>
+#include <libevp/model/evp_result.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <string_view>
+
+namespace libevp {
+    class mapped_file;
+
+    /*
+        evp index object
+
+        Pre-parsed file descriptor table, name hash table and sorted name order
+        of an archive, persisted in a sidecar file and loaded with a memory map.
+        Loading does no parsing and no per file allocation.
+
+        Views returned by queries point into the mapping and are valid until
+        the index is closed.
+    */
+    class evp_index {
+    public:
+        evp_index(const evp_index&) = delete;
+        evp_index(evp_index&&)      = delete;
+
+        LIBEVP_API evp_index();
+        LIBEVP_API ~evp_index();
+
+        evp_index& operator=(const evp_index&) = delete;
+        evp_index& operator=(evp_index&&)      = delete;
+
+    public:
+
+        /*
+         *  Get default sidecar file path for an archive.
+         *
+         *  @param archive  -> file path to archive
+         *
+         *  @returns FILE_PATH
+         *      archive path with .idx appended;
+        */
+        LIBEVP_API static FILE_PATH get_default_path(const FILE_PATH& archive);
+
+        /*
+         *  Parse archive and write its index sidecar file.
+         *
+         *  @param archive  -> file path to archive
+         *  @param index    -> file path where to save the sidecar, default path if empty
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         built successfully;
+         *      status == evp_result_status::failure    an error occurred, message contains details;
+        */
+        LIBEVP_API static evp_result build(const FILE_PATH& archive, const FILE_PATH& index = "");
+
+        /*
+         *  Map index sidecar file.
+         *  Fails if the sidecar does not match archive size, mtime and header.
+         *
+         *  @param archive  -> file path to archive
+         *  @param index    -> file path to sidecar, default path if empty
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         loaded successfully;
+         *      status == evp_result_status::failure    missing or stale sidecar, message contains details;
+        */
+        LIBEVP_API evp_result load(const FILE_PATH& archive, const FILE_PATH& index = "");
+
+        /*
+         *  Map index sidecar file, building it first if missing or stale.
+         *
+         *  @param archive  -> file path to archive
+         *  @param index    -> file path to sidecar, default path if empty
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         opened successfully;
+         *      status == evp_result_status::failure    an error occurred, message contains details;
+        */
+        LIBEVP_API evp_result open(const FILE_PATH& archive, const FILE_PATH& index = "");
+
+        /*
+         *  Unmap index.
+        */
+        LIBEVP_API void close();
+
+        /*
+         *  Get number of files in index.
+        */
+        LIBEVP_API size_t size() const;
+
+        /*
+         *  Get file fd at position.
+         *
+         *  @param index    -> position in descriptor table
+         *  @param fd       -> fd to fill
+        */
+        LIBEVP_API void get_fd(size_t index, evp_fd& fd) const;
+
+        /*
+         *  Find a file in index.
+         *
+         *  @param file     -> file to find
+         *  @param fd       -> fd to fill
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         found;
+         *      status == evp_result_status::failure    file not found;
+        */
+        LIBEVP_API evp_result find(const FILE_PATH& file, evp_fd& fd) const;
+
+        /*
+         *  Get file view at position.
+         *
+         *  @param index    -> position in descriptor table
+        */
+        LIBEVP_API evp_fd_view get_view(size_t index) const;
+
+        /*
+         *  Find files whose path starts with prefix.
+         *  O(log n + k)
+         *
+         *  @param prefix   -> path prefix, e.g. "data/maps/"
+         *
+         *  @returns std::vector<evp_fd_view>
+         *      matching files in name order;
+        */
+        LIBEVP_API std::vector<evp_fd_view> find_prefix(const FILE_PATH& prefix) const;
+
+        /*
+         *  List direct children of a directory.
+         *  O((k + d) log n), where d is the number of subdirectories
+         *
+         *  @param dir      -> directory path, empty for root
+         *  @param files    -> files directly inside dir
+         *  @param dirs     -> optional, names of subdirectories
+        */
+        LIBEVP_API void list_dir(const FILE_PATH& dir, std::vector<evp_fd_view>& files,
+            std::vector<std::string_view>* dirs = nullptr) const;
+
+        /*
+         *  Find files matching a glob pattern.
+         *  Supports `?`, `*` (within a directory) and `**` (across directories).
+         *  Only files under the literal pattern prefix are tested.
+         *
+         *  @param pattern  -> glob pattern, e.g. "data/maps/tex_??.dds"
+         *
+         *  @returns std::vector<evp_fd_view>
+         *      matching files in name order;
+        */
+        LIBEVP_API std::vector<evp_fd_view> glob(const FILE_PATH& pattern) const;
+
+    private:
+        struct record;
+
+    private:
+        std::unique_ptr<mapped_file> m_file;
+        const record*                m_records      = nullptr;
+        const uint32_t*              m_buckets      = nullptr;
+        const uint32_t*              m_sorted       = nullptr;
+        const char*                  m_names        = nullptr;
+        uint32_t                     m_count        = 0U;
+        uint32_t                     m_bucket_count = 0U;
+
+    private:
+        const record* find_record(const std::string& file) const;
+
+        std::string_view get_name(uint32_t index) const;
+
+        /*
+            Get range of sorted positions whose names start with prefix.
+        */
+        std::pair<uint32_t, uint32_t> get_prefix_range(std::string_view prefix, uint32_t first = 0U) const;
+    };
+}
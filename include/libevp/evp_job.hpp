@@ -0,0 +1,110 @@
+#pragma once
+
+#include <libevp/model/evp_result.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <condition_variable>
+
+namespace libevp {
+    /*
+        evp job handle
+
+        Returned by async operations. Can be waited on, polled and cancelled.
+        Copies refer to the same job.
+    */
+    class evp_job {
+    public:
+        enum class status : uint8_t {
+            invalid  = 0x0,
+            queued   = 0x1,
+            running  = 0x2,
+            finished = 0x3
+        };
+
+        struct state {
+            std::mutex              mutex;
+            std::condition_variable cv;
+            evp_job::status         status = evp_job::status::queued;
+            evp_result              result = {};
+            std::atomic_bool        cancel = false;
+
+            void set_running() {
+                std::lock_guard<std::mutex> guard(mutex);
+                status = evp_job::status::running;
+            }
+
+            void set_finished(const evp_result& job_result) {
+                {
+                    std::lock_guard<std::mutex> guard(mutex);
+                    status = evp_job::status::finished;
+                    result = job_result;
+                }
+
+                cv.notify_all();
+            }
+        };
+
+    public:
+        evp_job() = default;
+
+        evp_job(std::shared_ptr<state> state)
+            : m_state(state) {}
+
+    public:
+        bool is_valid() const {
+            return m_state != nullptr;
+        }
+
+        /*
+            Get current job status.
+        */
+        evp_job::status get_status() const {
+            if (!m_state) return evp_job::status::invalid;
+
+            std::lock_guard<std::mutex> guard(m_state->mutex);
+            return m_state->status;
+        }
+
+        /*
+            Request cancellation.
+            Queued jobs finish as cancelled without running,
+            running jobs stop at the next cancellation check.
+        */
+        void cancel() {
+            if (m_state)
+                m_state->cancel.store(true);
+        }
+
+        /*
+            Block until the job finishes.
+
+            @returns evp_result of the job
+        */
+        evp_result wait() const {
+            if (!m_state) return {};
+
+            std::unique_lock<std::mutex> lock(m_state->mutex);
+            m_state->cv.wait(lock, [&] { return m_state->status == evp_job::status::finished; });
+
+            return m_state->result;
+        }
+
+        /*
+            Block until the job finishes or timeout expires.
+
+            @returns true if finished
+        */
+        bool wait_for(std::chrono::milliseconds timeout) const {
+            if (!m_state) return false;
+
+            std::unique_lock<std::mutex> lock(m_state->mutex);
+            return m_state->cv.wait_for(lock, timeout, [&] { return m_state->status == evp_job::status::finished; });
+        }
+
+    private:
+        std::shared_ptr<state> m_state;
+    };
+}
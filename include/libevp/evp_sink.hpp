@@ -0,0 +1,120 @@
+#pragma once
+
+#include <libevp/evp_defs.hpp>
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+namespace libevp {
+    /*
+        evp sink object
+
+        Byte sink archives are packed into.
+        Derive to write archives to custom storage or use one of the factories.
+    */
+    class evp_sink {
+    public:
+        using ptr_t      = std::shared_ptr<evp_sink>;
+        using write_cb_t = std::function<bool(const uint8_t* src, size_t size)>;
+
+    public:
+        virtual ~evp_sink() = default;
+
+    public:
+
+        /*
+         *  Check if sink was opened.
+        */
+        virtual bool is_valid() const = 0;
+
+        /*
+         *  Get current write position.
+        */
+        virtual uint64_t pos() const = 0;
+
+        /*
+         *  Write bytes at current position.
+         *  Throws if writing fails.
+         *
+         *  @param src      -> bytes to write
+         *  @param size     -> number of bytes to write
+        */
+        virtual void write(const uint8_t* src, size_t size) = 0;
+
+        /*
+         *  Move write position.
+         *  Throws if sink isn't seekable or seeking fails.
+         *
+         *  @param offset   -> absolute offset
+        */
+        virtual void seek(uint64_t offset) = 0;
+
+        /*
+         *  Check if sink supports seek().
+        */
+        virtual bool is_seekable() const {
+            return true;
+        }
+
+        /*
+         *  Reserve space for the expected final size.
+         *  Best effort, does nothing by default.
+         *
+         *  @param size     -> expected final size
+         *
+         *  @returns bool
+         *      true if space was reserved;
+        */
+        virtual bool preallocate(uint64_t size) {
+            return false;
+        }
+
+        /*
+         *  Append part of a file at current position without reading it into memory.
+         *  Throws if copying fails part way.
+         *
+         *  @param file     -> file to copy from
+         *  @param offset   -> offset in file
+         *  @param size     -> number of bytes to copy
+         *
+         *  @returns bool
+         *      true if bytes were copied, false if not supported and nothing was written;
+        */
+        virtual bool copy_from(const FILE_PATH& file, uint64_t offset, uint64_t size) {
+            return false;
+        }
+
+        /*
+         *  Write out any data held by the sink.
+         *  Throws if writing fails.
+        */
+        virtual void flush() {}
+
+    public:
+
+        /*
+         *  Create sink writing to a file.
+         *
+         *  @param file     -> file path
+        */
+        LIBEVP_API static ptr_t from_file(const FILE_PATH& file);
+
+        /*
+         *  Create sink writing to a memory buffer.
+         *  Buffer is cleared and must outlive the sink.
+         *
+         *  @param buffer   -> buffer to write into
+        */
+        LIBEVP_API static ptr_t from_memory(std::vector<uint8_t>& buffer);
+
+        /*
+         *  Create non-seekable sink writing through a callback,
+         *  e.g. into a pipe or socket.
+         *
+         *  @param cb       -> callback that writes bytes, returns false on failure
+        */
+        LIBEVP_API static ptr_t from_callback(write_cb_t cb);
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <libevp/evp_defs.hpp>
+
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+namespace libevp {
+    /*
+        evp source object
+
+        Random access byte source archives are parsed from.
+        Derive to read archives from custom storage or use one of the factories.
+    */
+    class evp_source {
+    public:
+        using ptr_t     = std::shared_ptr<evp_source>;
+        using read_cb_t = std::function<bool(uint64_t offset, uint8_t* dst, size_t size)>;
+
+    public:
+        virtual ~evp_source() = default;
+
+    public:
+
+        /*
+         *  Get source size in bytes.
+        */
+        virtual uint64_t size() const = 0;
+
+        /*
+         *  Check if source was opened.
+        */
+        virtual bool is_valid() const = 0;
+
+        /*
+         *  Read bytes at offset.
+         *  Throws if offset + size is outside the source or reading fails.
+         *
+         *  @param offset   -> offset to read from
+         *  @param dst      -> buffer to read into
+         *  @param size     -> number of bytes to read
+        */
+        virtual void read(uint64_t offset, uint8_t* dst, size_t size) = 0;
+
+        /*
+         *  Get pointer to source contents if they are contiguous in memory.
+         *  Readers use it to skip copying.
+         *
+         *  @returns const uint8_t*
+         *      pointer to size() bytes, nullptr if not in memory;
+        */
+        virtual const uint8_t* data() const {
+            return nullptr;
+        }
+
+        /*
+         *  Get file the source contents are read from as is.
+         *  Sinks use it to copy data without reading it.
+         *
+         *  @param file     -> where to save file path
+         *  @param offset   -> where to save offset source contents start at
+         *
+         *  @returns bool
+         *      true if source reads straight from a file;
+        */
+        virtual bool get_file_extent(FILE_PATH& file, uint64_t& offset) const {
+            return false;
+        }
+
+    public:
+
+        /*
+         *  Create source reading from a file through a stream.
+         *
+         *  @param file     -> file path
+        */
+        LIBEVP_API static ptr_t from_file(const FILE_PATH& file);
+
+        /*
+         *  Create source reading part of a file through a stream.
+         *
+         *  @param file     -> file path
+         *  @param offset   -> offset the part starts at
+         *  @param size     -> size of the part
+        */
+        LIBEVP_API static ptr_t from_file_range(const FILE_PATH& file, uint64_t offset, uint64_t size);
+
+        /*
+         *  Create source reading from a memory mapped file.
+         *
+         *  @param file     -> file path
+        */
+        LIBEVP_API static ptr_t from_mapped_file(const FILE_PATH& file);
+
+        /*
+         *  Create source reading from memory.
+         *  Memory is not copied and must outlive the source.
+         *
+         *  @param data     -> pointer to archive contents
+         *  @param size     -> size of archive contents
+        */
+        LIBEVP_API static ptr_t from_memory(const uint8_t* data, size_t size);
+
+        /*
+         *  Create source reading through a callback.
+         *
+         *  @param size     -> size of archive contents
+         *  @param cb       -> callback that reads bytes at offset, returns false on failure
+        */
+        LIBEVP_API static ptr_t from_callback(uint64_t size, read_cb_t cb);
+    };
+}
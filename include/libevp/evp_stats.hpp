@@ -0,0 +1,157 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace libevp {
+    /*
+        evp stats
+
+        Per-phase counters filled in by operations run with a context that points to it.
+        Counters are relaxed atomics, safe to read while an operation is running.
+        One object can be shared by several operations, values accumulate until reset.
+    */
+    class evp_stats {
+    public:
+        enum class phase : uint8_t {
+            parse      = 0x0,  // header and file desc block reading
+            tea        = 0x1,  // TEA decoding
+            decompress = 0x2,  // zlib inflate
+            md5        = 0x3,  // hash computing
+            write      = 0x4,  // output writes
+            count      = 0x5
+        };
+
+        struct entry_stat {
+            uint64_t data_offset = 0U;   // identifies the entry inside its archive
+            uint64_t value       = 0U;   // size in bytes or time in ns
+        };
+
+        struct snapshot {
+            // entry data read from archives or pack inputs
+            uint64_t                 bytes_read      = 0U;
+            // entry data written to archives or unpack outputs
+            uint64_t                 bytes_written   = 0U;
+            std::chrono::nanoseconds parse_time      = {};
+            std::chrono::nanoseconds tea_time        = {};
+            std::chrono::nanoseconds decompress_time = {};
+            std::chrono::nanoseconds md5_time        = {};
+            std::chrono::nanoseconds write_time      = {};
+            uint64_t                 entry_count     = 0U;
+            // by decompressed size
+            entry_stat               largest_entry   = {};
+            // by total time spent on the entry
+            entry_stat               slowest_entry   = {};
+        };
+
+    public:
+        evp_stats()                 = default;
+        evp_stats(const evp_stats&) = delete;
+        evp_stats(evp_stats&&)      = delete;
+
+        evp_stats& operator=(const evp_stats&) = delete;
+        evp_stats& operator=(evp_stats&&)      = delete;
+
+    public:
+
+        /*
+            Get current values.
+        */
+        snapshot get() const {
+            snapshot result;
+            result.bytes_read      = m_bytes_read.load(std::memory_order_relaxed);
+            result.bytes_written   = m_bytes_written.load(std::memory_order_relaxed);
+            result.parse_time      = get_time(phase::parse);
+            result.tea_time        = get_time(phase::tea);
+            result.decompress_time = get_time(phase::decompress);
+            result.md5_time        = get_time(phase::md5);
+            result.write_time      = get_time(phase::write);
+            result.entry_count     = m_entry_count.load(std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> guard(m_entry_mutex);
+            result.largest_entry = m_largest_entry;
+            result.slowest_entry = m_slowest_entry;
+
+            return result;
+        }
+
+        /*
+            Zero all counters.
+        */
+        void reset() {
+            m_bytes_read.store(0U, std::memory_order_relaxed);
+            m_bytes_written.store(0U, std::memory_order_relaxed);
+            m_entry_count.store(0U, std::memory_order_relaxed);
+
+            for (auto& time : m_times)
+                time.store(0U, std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> guard(m_entry_mutex);
+            m_largest_entry = {};
+            m_slowest_entry = {};
+            m_largest_size.store(0U, std::memory_order_relaxed);
+            m_slowest_time.store(0U, std::memory_order_relaxed);
+        }
+
+    public:
+        void add_bytes_read(uint64_t bytes) {
+            m_bytes_read.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        void add_bytes_written(uint64_t bytes) {
+            m_bytes_written.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        void add_time(phase phase, std::chrono::nanoseconds time) {
+            m_times[(size_t)phase].fetch_add((uint64_t)time.count(), std::memory_order_relaxed);
+        }
+
+        /*
+            Record a processed entry.
+            Lock is only taken when the entry is a new largest or slowest one.
+        */
+        void add_entry(uint64_t data_offset, uint64_t size, std::chrono::nanoseconds time) {
+            uint64_t time_ns = (uint64_t)time.count();
+
+            m_entry_count.fetch_add(1U, std::memory_order_relaxed);
+
+            if (size <= m_largest_size.load(std::memory_order_relaxed) &&
+                time_ns <= m_slowest_time.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> guard(m_entry_mutex);
+
+            if (size > m_largest_entry.value) {
+                m_largest_entry = { data_offset, size };
+                m_largest_size.store(size, std::memory_order_relaxed);
+            }
+
+            if (time_ns > m_slowest_entry.value) {
+                m_slowest_entry = { data_offset, time_ns };
+                m_slowest_time.store(time_ns, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        std::atomic_uint64_t m_bytes_read    = 0U;
+        std::atomic_uint64_t m_bytes_written = 0U;
+        std::atomic_uint64_t m_entry_count   = 0U;
+        std::atomic_uint64_t m_times[(size_t)phase::count] = {};
+
+        std::atomic_uint64_t m_largest_size  = 0U;
+        std::atomic_uint64_t m_slowest_time  = 0U;
+
+        mutable std::mutex   m_entry_mutex;
+        entry_stat           m_largest_entry = {};
+        entry_stat           m_slowest_entry = {};
+
+    private:
+        std::chrono::nanoseconds get_time(phase phase) const {
+            return std::chrono::nanoseconds(m_times[(size_t)phase].load(std::memory_order_relaxed));
+        }
+    };
+}
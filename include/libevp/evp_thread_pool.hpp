@@ -0,0 +1,98 @@
+#pragma once
+
+#include <libevp/evp_defs.hpp>
+
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+namespace libevp {
+    /*
+        evp thread pool
+
+        Fixed set of worker threads running queued tasks in order.
+        Tasks posted as I/O heavy additionally share a process wide concurrency limit,
+        they wait in their own queue until a slot is free so they never block a worker.
+    */
+    class evp_thread_pool {
+    public:
+        using task_t = std::function<void()>;
+
+    public:
+        evp_thread_pool()                       = delete;
+        evp_thread_pool(const evp_thread_pool&) = delete;
+        evp_thread_pool(evp_thread_pool&&)      = delete;
+
+        /*
+         *  @param thread_count -> number of worker threads, 0 for hardware concurrency
+        */
+        LIBEVP_API evp_thread_pool(uint32_t thread_count);
+
+        /*
+         *  Runs remaining queued tasks and joins workers.
+        */
+        LIBEVP_API ~evp_thread_pool();
+
+        evp_thread_pool& operator=(const evp_thread_pool&) = delete;
+        evp_thread_pool& operator=(evp_thread_pool&&)      = delete;
+
+    public:
+
+        /*
+         *  Get pool shared by evp instances without their own pool.
+        */
+        LIBEVP_API static std::shared_ptr<evp_thread_pool> get_global();
+
+        /*
+         *  Set max number of I/O heavy tasks running at once across all pools.
+         *
+         *  @param limit    -> max concurrent tasks, 0 for no limit
+        */
+        LIBEVP_API static void set_io_limit(uint32_t limit);
+
+        /*
+         *  Get max number of I/O heavy tasks running at once across all pools.
+        */
+        LIBEVP_API static uint32_t get_io_limit();
+
+    public:
+
+        /*
+         *  Queue a task.
+        */
+        LIBEVP_API void post(task_t task);
+
+        /*
+         *  Queue an I/O heavy task, subject to the global I/O limit.
+        */
+        LIBEVP_API void post_io(task_t task);
+
+        /*
+         *  Block until queue is empty and no task is running.
+        */
+        LIBEVP_API void wait_idle();
+
+        /*
+         *  Get number of worker threads.
+        */
+        LIBEVP_API size_t get_thread_count() const;
+
+    private:
+        std::mutex               m_mutex;
+        std::condition_variable  m_cv;
+        std::condition_variable  m_idle_cv;
+        std::deque<task_t>       m_tasks;
+        std::deque<task_t>       m_io_tasks;
+        std::vector<std::thread> m_threads;
+        uint32_t                 m_running = 0U;
+        bool                     m_stop    = false;
+
+    private:
+        void worker();
+    };
+}
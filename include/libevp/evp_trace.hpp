@@ -0,0 +1,99 @@
+#pragma once
+
+#include <libevp/evp_defs.hpp>
+#include <libevp/model/evp_result.hpp>
+#include <libevp/model/evp_access_record.hpp>
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace libevp {
+    /*
+        evp trace object
+
+        Collects timed spans of operations run with a context that points to it
+        and exports them in the Chrome trace event format (chrome://tracing, Perfetto).
+        Nothing is recorded when a context has no trace set.
+    */
+    class evp_trace {
+    public:
+        using clock_t = std::chrono::steady_clock;
+
+        struct span {
+            const char*         name        = "";           // string literal
+            const char*         category    = "";           // string literal
+            clock_t::time_point start       = {};
+            clock_t::time_point end         = {};
+            uint64_t            data_offset = UINT64_MAX;   // UINT64_MAX if not bound to an entry
+            std::string         file        = "";
+        };
+
+    public:
+        evp_trace(const evp_trace&) = delete;
+        evp_trace(evp_trace&&)      = delete;
+
+        LIBEVP_API evp_trace();
+
+        evp_trace& operator=(const evp_trace&) = delete;
+        evp_trace& operator=(evp_trace&&)      = delete;
+
+    public:
+
+        /*
+         *  Record a finished span on the calling thread.
+        */
+        LIBEVP_API void add_span(span span);
+
+        /*
+         *  Remove recorded spans and thread ids.
+        */
+        LIBEVP_API void clear();
+
+        /*
+         *  Get number of recorded spans.
+        */
+        LIBEVP_API size_t size() const;
+
+        /*
+         *  Get entries in the order they were first accessed.
+         *  Can be passed to the packer to lay entries out in that order.
+         *
+         *  @returns std::vector<evp_access_record>
+         *      entries with time of first access in ns since trace creation;
+        */
+        LIBEVP_API std::vector<evp_access_record> get_access_records() const;
+
+        /*
+         *  Get recorded spans as trace event JSON.
+        */
+        LIBEVP_API std::string to_json() const;
+
+        /*
+         *  Save recorded spans as trace event JSON.
+         *
+         *  @param output   -> file path to save to
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         saved;
+         *      status == evp_result_status::failure    an error occurred, message contains details;
+        */
+        LIBEVP_API evp_result save(const FILE_PATH& output) const;
+
+    private:
+        struct event {
+            evp_trace::span span = {};
+            uint32_t        tid  = 0U;
+        };
+
+    private:
+        mutable std::mutex                            m_mutex;
+        clock_t::time_point                           m_origin;
+        std::vector<event>                            m_events;
+        std::unordered_map<std::thread::id, uint32_t> m_threads;
+    };
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <libevp/evp.hpp>
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace libevp {
+    /*
+        evp virtual filesystem
+
+        Overlays multiple archives into a single name index.
+        Archives with higher priority shadow files in archives with lower priority,
+        on equal priority the archive mounted last wins.
+    */
+    class evp_vfs {
+    public:
+        struct entry {
+            FILE_PATH archive = "";
+            evp_fd    fd      = {};
+        };
+
+    public:
+        evp_vfs()               = default;
+        evp_vfs(const evp_vfs&) = delete;
+        evp_vfs(evp_vfs&&)      = delete;
+
+        evp_vfs& operator=(const evp_vfs&) = delete;
+        evp_vfs& operator=(evp_vfs&&)      = delete;
+
+    public:
+
+        /*
+         *  Mount an archive.
+         *  Only files of the mounted archive are merged into the index.
+         *
+         *  @param archive  -> file path to archive
+         *  @param priority -> higher priority archives shadow lower priority ones
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         mounted successfully;
+         *      status == evp_result_status::failure    an error occurred, message contains details;
+        */
+        LIBEVP_API evp_result mount(const FILE_PATH& archive, int32_t priority = 0);
+
+        /*
+         *  Unmount an archive.
+         *  Only files owned by the unmounted archive are resolved again.
+         *
+         *  @param archive  -> file path to archive
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         unmounted successfully;
+         *      status == evp_result_status::failure    archive not mounted;
+        */
+        LIBEVP_API evp_result unmount(const FILE_PATH& archive);
+
+        /*
+         *  Get mounted archives ordered from highest to lowest priority.
+        */
+        LIBEVP_API std::vector<FILE_PATH> get_mounts() const;
+
+        /*
+         *  Get number of visible files.
+        */
+        LIBEVP_API size_t size() const;
+
+        /*
+         *  Find a file in mounted archives.
+         *
+         *  @param file     -> file to find
+         *  @param entry    -> owning archive and file fd
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         found;
+         *      status == evp_result_status::failure    file not found;
+        */
+        LIBEVP_API evp_result find(const FILE_PATH& file, entry& entry) const;
+
+        /*
+         *  Unpack a single file from mounted archives into a buffer.
+         *
+         *  @param file     -> file to unpack
+         *  @param buffer   -> buffer to unpack into
+         *
+         *  @returns evp_result
+         *      status == evp_result_status::ok         unpacked successfully;
+         *      status == evp_result_status::failure    an error occurred during unpacking, message contains details;
+        */
+        LIBEVP_API evp_result get_file(const FILE_PATH& file, std::vector<uint8_t>& buffer);
+
+        /*
+         *  Set cache used to store decoded files.
+         *
+         *  @param cache    -> cache to use, nullptr to disable caching
+        */
+        LIBEVP_API void set_cache(std::shared_ptr<evp_cache> cache);
+
+    private:
+        struct mount_t {
+            FILE_PATH                                 archive  = "";
+            int32_t                                   priority = 0;
+            uint64_t                                  order    = 0U;
+            std::vector<evp_fd>                       files    = {};
+            std::unordered_map<std::string, uint32_t> index    = {};
+
+            bool shadows(const mount_t& other) const {
+                if (priority != other.priority)
+                    return priority > other.priority;
+
+                return order > other.order;
+            }
+        };
+
+        struct ref_t {
+            const mount_t* mount = nullptr;
+            uint32_t       index = 0U;
+        };
+
+    private:
+        mutable std::shared_mutex              m_mutex;
+        evp                                    m_evp;
+        std::vector<std::unique_ptr<mount_t>>  m_mounts;
+        std::unordered_map<std::string, ref_t> m_index;
+        uint64_t                               m_order = 0U;
+    };
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace libevp {
+    struct evp_access_record {
+        std::string file = "";  // path inside archive
+        uint64_t    time = 0U;  // optional time of access, 0 if unknown
+    };
+}
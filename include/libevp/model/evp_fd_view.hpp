@@ -0,0 +1,43 @@
+#pragma once
+
+#include <libevp/model/evp_fd.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace libevp {
+    /*
+        Non-owning view of a file fd.
+
+        Valid only while the table it was taken from is alive.
+    */
+    struct evp_fd_view {
+        std::string_view file                 = "";
+        uint64_t         data_offset          = 0U;
+        uint64_t         data_size            = 0U;
+        uint64_t         data_compressed_size = 0U;
+        uint32_t         flags                = 0U;
+        const uint8_t*   hash                 = nullptr;
+
+        evp_fd_view() = default;
+
+        evp_fd_view(const evp_fd& fd)
+            : file(fd.file), data_offset(fd.data_offset), data_size(fd.data_size),
+              data_compressed_size(fd.data_compressed_size), flags(fd.flags), hash(fd.hash.data()) {}
+
+        evp_fd to_fd() const {
+            evp_fd fd;
+            fd.file                 = std::string(file);
+            fd.data_offset          = data_offset;
+            fd.data_size            = data_size;
+            fd.data_compressed_size = data_compressed_size;
+            fd.flags                = flags;
+
+            if (hash)
+                memcpy(fd.hash.data(), hash, fd.hash.size());
+
+            return fd;
+        }
+    };
+}
@@ -4,7 +4,9 @@
 #include <cstdint>
 
 namespace libevp {
-    constexpr uint32_t EVP_READ_CHUNK_SIZE = 16 * 1024;
+    constexpr uint32_t EVP_READ_CHUNK_SIZE   = 16 * 1024;
+    constexpr uint32_t EVP_WRITE_BUFFER_SIZE = 1024 * 1024;
+    constexpr uint32_t EVP_COPY_CHUNK_SIZE   = 16 * 1024 * 1024;
 
     using buffer_t = std::vector<uint8_t>;
 }
@@ -4,13 +4,19 @@
 #include "libevp/stream/stream_read.hpp"
 #include "libevp/stream/stream_write.hpp"
 #include "libevp/misc/evp_context_internal.hpp"
+#include "libevp/misc/extract_writer.hpp"
+#include "libevp/misc/stats_timer.hpp"
+#include "libevp/misc/trace_span.hpp"
 #include "libevp/utilities/string.hpp"
 #include "libevp/defs.hpp"
 
 #include <md5/md5.hpp>
-#include <thread>
 #include <vector>
+#include <cstring>
+#include <algorithm>
+#include <set>
 #include <unordered_set>
+#include <unordered_map>
 
 using namespace libevp;
 
@@ -20,12 +26,13 @@ using namespace libevp;
 /*
     Determines format and reads file descriptors.
 */
-static evp_result read_structure(fstream_read& stream, libevp::format::format::ptr_t& format);
+static evp_result read_structure(source_read& stream, libevp::format::format::ptr_t& format,
+    const evp_context_internal* context = nullptr);
 
 /*
     Determine archive format.
 */
-static evp_result determine_format(fstream_read& stream, std::shared_ptr<libevp::format::format>& format);
+static evp_result determine_format(source_read& stream, std::shared_ptr<libevp::format::format>& format);
 
 /*
     Validate that input is an EVP archive.
@@ -37,6 +44,34 @@ static evp_result validate_evp_archive(const FILE_PATH& input, bool existing);
 */
 static evp_result validate_directory(const DIR_PATH& input);
 
+/*
+    Read and decode a single file from archive.
+*/
+static evp_result read_file(const evp_source::ptr_t& input, const evp_fd& file, buffer_t& buffer);
+
+/*
+    Decode a single file from an opened archive.
+*/
+static void decode_file(source_read& stream, libevp::format::format::ptr_t& format, const evp_fd_view& file,
+    buffer_t& buffer);
+
+/*
+    Get string identifying archive path and version.
+*/
+static std::string get_archive_identity(const FILE_PATH& input);
+
+/*
+    Finish an async job that threw with failure.
+*/
+static void fail_job(evp_job::state& state, evp_context_internal& context, std::string message);
+
+/*
+    Get order entries are laid out in. Traced entries come first in order of
+    first access, the rest keeps input order grouped by directory.
+*/
+static std::vector<size_t> get_layout_order(const std::vector<evp::pack_entry>& entries,
+    std::vector<evp_access_record> trace);
+
 /*
     Convert MD5 string to bytes
 */
@@ -51,14 +86,36 @@ namespace libevp {
         static evp_result pack_impl(const evp::pack_input input, FILE_PATH output,
             evp_context_internal& context);
 
+        static evp_result pack_impl(evp::pack_source_input input, evp_sink::ptr_t output,
+            evp_context_internal& context, std::vector<evp_hash_cache::hash_t>* hashes = nullptr);
+
         static evp_result unpack_impl(evp::unpack_input input, DIR_PATH output,
             evp_context_internal& context);
+
+        static evp_result transcode_impl(const evp::transcode_input& input, evp_sink::ptr_t output,
+            evp_context_internal& context);
     };
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // PUBLIC
 
+void evp::set_cache(std::shared_ptr<evp_cache> cache) {
+    m_cache = cache;
+}
+
+std::shared_ptr<evp_cache> evp::get_cache() const {
+    return m_cache;
+}
+
+void evp::set_thread_pool(std::shared_ptr<evp_thread_pool> pool) {
+    m_pool = pool;
+}
+
+std::shared_ptr<evp_thread_pool> evp::get_thread_pool() const {
+    return m_pool ? m_pool : evp_thread_pool::get_global();
+}
+
 evp_result evp::pack(const pack_input& input, const FILE_PATH& output) {
     try {
         evp_context_internal context_internal(nullptr);
@@ -73,6 +130,20 @@ evp_result evp::pack(const pack_input& input, const FILE_PATH& output) {
     }
 }
 
+evp_result evp::pack(const pack_source_input& input, const evp_sink::ptr_t& output) {
+    try {
+        evp_context_internal context_internal(nullptr);
+        return evp_impl::pack_impl(input, output, context_internal);
+    }
+    catch (const std::exception& e) {
+        evp_result result;
+        result.status  = evp_result::status::failure;
+        result.message = EVP_STR_FORMAT("pack() ex | {}", e.what());
+
+        return result;
+    }
+}
+
 evp_result evp::unpack(const unpack_input& input, const DIR_PATH& output) {
     try {
         evp_context_internal context_internal(nullptr);
@@ -87,43 +158,77 @@ evp_result evp::unpack(const unpack_input& input, const DIR_PATH& output) {
     }
 }
 
-void evp::pack_async(const pack_input& input, const FILE_PATH& output, evp_context* context) {
-    std::thread t([input, output, context] {
+evp_result evp::transcode(const transcode_input& input, const evp_sink::ptr_t& output, evp_context* context) {
+    try {
         evp_context_internal context_internal(context);
+        return evp_impl::transcode_impl(input, output, context_internal);
+    }
+    catch (const std::exception& e) {
+        evp_result result;
+        result.status  = evp_result::status::failure;
+        result.message = EVP_STR_FORMAT("transcode() ex | {}", e.what());
+
+        return result;
+    }
+}
 
+evp_job evp::pack_async(const pack_input& input, const FILE_PATH& output, evp_context* context) {
+    auto state = std::make_shared<evp_job::state>();
+
+    get_thread_pool()->post_io([input, output, context, state] {
+        evp_context_internal context_internal(context, &state->cancel);
+
+        // anything escaping would leave the job unfinished
         try {
-            evp_impl::pack_impl(input, output, context_internal);
+            if (context_internal.is_cancelled()) {
+                context_internal.invoke_cancel();
+                state->set_finished({ evp_result::status::cancelled, "" });
+                return;
+            }
+
+            state->set_running();
+            state->set_finished(evp_impl::pack_impl(input, output, context_internal));
         }
         catch (const std::exception& e) {
-            evp_result result;
-            result.status  = evp_result::status::failure;
-            result.message = EVP_STR_FORMAT("pack_async() ex | {}", e.what());
-
-            context_internal.invoke_finish(result);
+            fail_job(*state, context_internal, EVP_STR_FORMAT("pack_async() ex | {}", e.what()));
+        }
+        catch (...) {
+            fail_job(*state, context_internal, EVP_STR_FORMAT("pack_async() ex | Unknown exception."));
         }
     });
-    t.detach();
+
+    return evp_job(state);
 }
 
-void evp::unpack_async(const unpack_input& input, const DIR_PATH& output, evp_context* context) {
-    std::thread t([input, output, context] {
-        evp_context_internal context_internal(context);
+evp_job evp::unpack_async(const unpack_input& input, const DIR_PATH& output, evp_context* context) {
+    auto state = std::make_shared<evp_job::state>();
 
+    get_thread_pool()->post_io([input, output, context, state] {
+        evp_context_internal context_internal(context, &state->cancel);
+
+        // anything escaping would leave the job unfinished
         try {
-            evp_impl::unpack_impl(input, output, context_internal);
+            if (context_internal.is_cancelled()) {
+                context_internal.invoke_cancel();
+                state->set_finished({ evp_result::status::cancelled, "" });
+                return;
+            }
+
+            state->set_running();
+            state->set_finished(evp_impl::unpack_impl(input, output, context_internal));
         }
         catch (const std::exception& e) {
-            evp_result result;
-            result.status  = evp_result::status::failure;
-            result.message = EVP_STR_FORMAT("unpack_async() ex | {}", e.what());
-
-            context_internal.invoke_finish(result);
+            fail_job(*state, context_internal, EVP_STR_FORMAT("unpack_async() ex | {}", e.what()));
+        }
+        catch (...) {
+            fail_job(*state, context_internal, EVP_STR_FORMAT("unpack_async() ex | Unknown exception."));
         }
     });
-    t.detach();
+
+    return evp_job(state);
 }
 
-evp_result evp::validate_files(const FILE_PATH& input, std::vector<evp_fd>* failed_files) {
+evp_result evp::validate_files(const FILE_PATH& input, std::vector<evp_fd>* failed_files, evp_context* context) {
     evp_result result, res;
     result.status = evp_result::status::failure;
 
@@ -133,46 +238,30 @@ evp_result evp::validate_files(const FILE_PATH& input, std::vector<evp_fd>* fail
         return result;
     }
 
-    fstream_read stream(input);
-    if (!stream.is_valid()) {
-        result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
-        return result;
-    }
-
-    format::format::ptr_t format;
-    res = read_structure(stream, format);
-    if (!res) {
-        result.message = res.message;
-        return result;
-    }
+    return validate_files(evp_source::from_file(input), failed_files, context);
+}
 
-    uint32_t failed_count = 0U;
-    for (auto& file : format->desc_block->files) {
-        MD5                     md5;
-        std::array<uint8_t, 16> hash      = {};
-        uint32_t                read_size = 0U;
+evp_result evp::validate_files(const evp_source::ptr_t& input, std::vector<evp_fd>* failed_files, evp_context* context) {
+    std::vector<validate_issue> issues;
 
-        format->read_file_data(stream, file, [&](uint8_t* data, uint32_t size) {
-            md5.add(data, size);
-            read_size += size;
-        });
+    evp_result result = validate(input, validate_input(), &issues, context);
 
-        if (read_size)
-            MD5_hex_string_to_bytes(md5, hash.data());
-        
-        if (memcmp(hash.data(), file.hash.data(), 16) != 0) {
-            failed_count++;
+    if (failed_files) {
+        std::set<std::pair<uint64_t, std::string>> reported;
 
-            if (failed_files)
-                failed_files->push_back(file);
+        // an entry can have both structural and data issues, report it once
+        for (validate_issue& issue : issues) {
+            if (reported.emplace(issue.fd.data_offset, issue.fd.file).second)
+                failed_files->push_back(std::move(issue.fd));
         }
     }
 
-    result.status = failed_count == 0 ? evp_result::status::ok : evp_result::status::failure;
     return result;
 }
 
-evp_result evp::get_archive_fds(const FILE_PATH& input, std::vector<evp_fd>& files) {
+evp_result evp::validate(const FILE_PATH& input, const validate_input& options, std::vector<validate_issue>* issues,
+    evp_context* context)
+{
     evp_result result, res;
     result.status = evp_result::status::failure;
 
@@ -182,81 +271,245 @@ evp_result evp::get_archive_fds(const FILE_PATH& input, std::vector<evp_fd>& fil
         return result;
     }
 
-    fstream_read stream(input);
+    return validate(evp_source::from_file(input), options, issues, context);
+}
+
+evp_result evp::validate(const evp_source::ptr_t& input, const validate_input& options, std::vector<validate_issue>* issues,
+    evp_context* context)
+{
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    evp_context_internal context_internal(context);
+
+    source_read stream(input);
     if (!stream.is_valid()) {
         result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
         return result;
     }
 
+    evp_stats* stats = context_internal.get_stats();
+    evp_trace* trace = context_internal.get_trace();
+
     format::format::ptr_t format;
-    res = read_structure(stream, format);
+    res = read_structure(stream, format, &context_internal);
     if (!res) {
         result.message = res.message;
         return result;
     }
 
-    for (auto& file : format->desc_block->files) {
-        files.push_back(file);
+    format->context = &context_internal;
+
+    const entry_table& files = format->desc_block->files;
+
+    uint32_t issue_count = 0U;
+    auto     add_issue   = [&](const evp_fd_view& fd, validate_issue::type kind, std::string message) {
+        issue_count++;
+
+        if (issues)
+            issues->push_back({ fd.to_fd(), kind, std::move(message) });
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTURAL
+
+    uint64_t archive_size = (uint64_t)stream.size();
+    uint64_t header_end   = format->get_format_desc_size();
+    uint64_t desc_begin   = format->file_desc_block_offset;
+    uint64_t desc_end     = desc_begin + format->file_desc_block_size;
+
+    if (desc_end < desc_begin || desc_end > archive_size) {
+        result.message = EVP_STR_FORMAT("File desc block is outside archive.");
+        return result;
+    }
+
+    std::vector<size_t> by_offset;
+    by_offset.reserve(files.size());
+
+    // entries outside archive data can't be read
+    std::vector<bool> outside(files.size(), false);
+
+    for (size_t i = 0; i < files.size(); i++) {
+        evp_fd_view fd   = files[i];
+        uint64_t    size = format->get_data_size_in_archive(fd);
+        uint64_t    end  = fd.data_offset + size;
+
+        if (size == 0U)
+            continue;
+
+        if (end < fd.data_offset || end > archive_size || fd.data_offset < header_end ||
+            (fd.data_offset < desc_end && end > desc_begin))
+        {
+            add_issue(fd, validate_issue::type::out_of_bounds,
+                EVP_STR_FORMAT("Data [{}, {}) is outside archive data.", fd.data_offset, end));
+
+            outside[i] = true;
+            continue;
+        }
+
+        by_offset.push_back(i);
     }
 
-    result.status = evp_result::status::ok;
-    return result;
-}
+    // one sort over ranges finds overlapping and duplicate ones, identical ranges end up next to each other
+    std::sort(by_offset.begin(), by_offset.end(), [&](size_t a, size_t b) {
+        if (files[a].data_offset != files[b].data_offset)
+            return files[a].data_offset < files[b].data_offset;
 
-evp_result evp::get_file(const FILE_PATH& input, const evp_fd& file, std::vector<uint8_t>& buffer) {
-    evp_result result, res;
-    result.status = evp_result::status::failure;
+        return format->get_data_size_in_archive(files[a]) < format->get_data_size_in_archive(files[b]);
+    });
 
-    res = validate_evp_archive(input, true);
-    if (!res) {
-        result.message = res.message;
+    size_t   previous     = SIZE_MAX;
+    size_t   furthest     = SIZE_MAX;
+    uint64_t furthest_end = 0U;
+
+    for (size_t i : by_offset) {
+        evp_fd_view fd   = files[i];
+        uint64_t    size = format->get_data_size_in_archive(fd);
+
+        if (furthest != SIZE_MAX && fd.data_offset < furthest_end) {
+            evp_fd_view prev = files[previous];
+
+            if (prev.data_offset == fd.data_offset && format->get_data_size_in_archive(prev) == size)
+                add_issue(fd, validate_issue::type::duplicate, EVP_STR_FORMAT("Data range is the same as `{}`.", prev.file));
+            else
+                add_issue(fd, validate_issue::type::overlap, EVP_STR_FORMAT("Data overlaps `{}`.", files[furthest].file));
+        }
+
+        previous = i;
+
+        if (fd.data_offset + size > furthest_end) {
+            furthest     = i;
+            furthest_end = fd.data_offset + size;
+        }
+    }
+
+    // full tier still hashes every readable entry
+    if (issue_count != 0U && options.tier != validate_tier::full) {
+        result.message = EVP_STR_FORMAT("{} entries failed structural validation.", issue_count);
         return result;
     }
 
-    fstream_read stream(input);
-    if (!stream.is_valid()) {
-        result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
+    if (options.tier == validate_tier::structural) {
+        result.status = evp_result::status::ok;
         return result;
     }
 
-    try {
-        buffer.resize(file.data_size);
-        
-        stream.seek(file.data_offset, std::ios::beg);
-        stream.read(buffer.data(), file.data_size);
+    ///////////////////////////////////////////////////////////////////////////
+    // QUICK / FULL
+
+    std::vector<size_t> hashed;
+
+    if (options.tier == validate_tier::full || files.size() <= options.sample_count) {
+        hashed.reserve(files.size());
+
+        for (size_t i = 0; i < files.size(); i++) {
+            if (!outside[i])
+                hashed.push_back(i);
+        }
     }
-    catch (const std::exception& e) {
-        result.message = e.what();
-        return result;
+    else {
+        // sample spread evenly over the archive
+        for (size_t i = 0; i < options.sample_count; i++) {
+            hashed.push_back(i * files.size() / options.sample_count);
+        }
     }
 
-    result.status = evp_result::status::ok;
-    return result;
-}
+    uint64_t prog_total = 0U;
+    for (size_t i : hashed) {
+        prog_total += files[i].data_size;
+    }
 
-evp_result evp::get_file(const FILE_PATH& input, const evp_fd& file, std::stringstream& stream) {
-    buffer_t buffer;
+    context_internal.set_progress_total(prog_total);
 
-    auto result = get_file(input, file, buffer);
-    if (!result)
+    try {
+        // headers of entries that aren't hashed
+        if (options.tier == validate_tier::quick) {
+            for (size_t i = 0; i < files.size(); i++) {
+                format->check_cancelled();
+
+                evp_fd_view fd = files[i];
+
+                if (!format->check_data_start(stream, fd))
+                    add_issue(fd, validate_issue::type::corrupt, EVP_STR_FORMAT("Unsupported data header."));
+            }
+        }
+
+        for (size_t i : hashed) {
+            evp_fd_view fd = files[i];
+
+            MD5                     md5;
+            std::array<uint8_t, 16> hash      = {};
+            uint64_t                read_size = 0U;
+
+            stats_timer entry_timer(stats);
+            trace_span  entry_span(trace, "entry", "entry", fd.data_offset, fd.file);
+
+            format->check_cancelled();
+
+            try {
+                format->read_file_data(stream, fd, [&](const uint8_t* data, uint32_t size) {
+                    stats_timer timer(stats, evp_stats::phase::md5);
+                    trace_span  span(trace, "md5", "codec", fd.data_offset);
+
+                    md5.add(data, size);
+                    read_size += size;
+                    context_internal.add_progress(size);
+                });
+            }
+            catch (const evp_cancelled_exception&) {
+                throw;
+            }
+            catch (const std::exception& e) {
+                add_issue(fd, validate_issue::type::corrupt, EVP_STR_FORMAT("Failed to decode data. | {}", e.what()));
+                continue;
+            }
+
+            if (read_size) {
+                stats_timer timer(stats, evp_stats::phase::md5);
+                MD5_hex_string_to_bytes(md5, hash.data());
+            }
+
+            if (stats)
+                stats->add_entry(fd.data_offset, fd.data_size, entry_timer.elapsed());
+
+            if (memcmp(hash.data(), fd.hash, 16) != 0)
+                add_issue(fd, validate_issue::type::hash_mismatch, EVP_STR_FORMAT("Data doesn't match stored hash."));
+        }
+    }
+    catch (const evp_cancelled_exception&) {
+        result.status = evp_result::status::cancelled;
         return result;
+    }
 
-    std::move(buffer.begin(), buffer.end(), std::ostream_iterator<unsigned char>(stream));
+    context_internal.flush_progress();
+
+    if (issue_count != 0U) {
+        result.message = EVP_STR_FORMAT("{} entries failed validation.", issue_count);
+        return result;
+    }
 
+    result.status = evp_result::status::ok;
     return result;
 }
 
-evp_result evp::get_file(const FILE_PATH& input, const FILE_PATH& file, std::vector<uint8_t>& buffer) {
+evp_result evp::get_archive_fds(const FILE_PATH& input, std::vector<evp_fd>& files) {
     evp_result result, res;
     result.status = evp_result::status::failure;
-    
+
     res = validate_evp_archive(input, true);
     if (!res) {
         result.message = res.message;
         return result;
     }
 
-    fstream_read stream(input);
+    return get_archive_fds(evp_source::from_file(input), files);
+}
+
+evp_result evp::get_archive_fds(const evp_source::ptr_t& input, std::vector<evp_fd>& files) {
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    source_read stream(input);
     if (!stream.is_valid()) {
         result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
         return result;
@@ -269,36 +522,37 @@ evp_result evp::get_file(const FILE_PATH& input, const FILE_PATH& file, std::vec
         return result;
     }
 
-    try {
-        bool found = false;
-
-        for (evp_fd& fd : format->desc_block->files) {
-            if (fd.file != file) continue;
+    files.reserve(files.size() + format->desc_block->files.size());
 
-            buffer.resize(fd.data_size);
+    for (evp_fd_view file : format->desc_block->files) {
+        files.push_back(file.to_fd());
+    }
 
-            stream.seek(fd.data_offset, std::ios::beg);
-            stream.read(buffer.data(), fd.data_size);
+    result.status = evp_result::status::ok;
+    return result;
+}
 
-            found = true;
-        }
+evp_result evp::get_file(const FILE_PATH& input, const evp_fd& file, std::vector<uint8_t>& buffer) {
+    if (!m_cache) {
+        evp_result result = validate_evp_archive(input, true);
+        if (!result)
+            return result;
 
-        if (found) {
-            result.status = evp_result::status::ok;
-        }
-        else {
-            result.message = EVP_STR_FORMAT("File not found.");
-        }
+        return read_file(evp_source::from_file(input), file, buffer);
     }
-    catch (const std::exception& e) {
-        result.message = e.what();
+
+    evp_cache::buffer_ptr_t shared;
+
+    auto result = get_file(input, file, shared);
+    if (!result)
         return result;
-    }
+
+    buffer.assign(shared->begin(), shared->end());
 
     return result;
 }
 
-evp_result evp::get_file(const FILE_PATH& input, const FILE_PATH& file, std::stringstream& stream) {
+evp_result evp::get_file(const FILE_PATH& input, const evp_fd& file, std::stringstream& stream) {
     buffer_t buffer;
 
     auto result = get_file(input, file, buffer);
@@ -310,63 +564,301 @@ evp_result evp::get_file(const FILE_PATH& input, const FILE_PATH& file, std::str
     return result;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// INTERNAL
-
-evp_result read_structure(fstream_read& stream, libevp::format::format::ptr_t& format) {
-    evp_result result;
+evp_result evp::get_file(const FILE_PATH& input, const evp_fd& file, evp_cache::buffer_ptr_t& buffer) {
+    evp_result result, res;
     result.status = evp_result::status::failure;
 
-    try {
-        auto res = determine_format(stream, format);
-        if (!res) {
-            result.message = EVP_STR_FORMAT("Archive format not supported.");
+    res = validate_evp_archive(input, true);
+    if (!res) {
+        result.message = res.message;
+        return result;
+    }
+
+    std::string identity = "";
+
+    if (m_cache) {
+        try {
+            identity = get_archive_identity(input);
+        }
+        catch (const std::exception& e) {
+            result.message = e.what();
             return result;
         }
 
-        if (!format) {
-            result.message = EVP_STR_FORMAT("Archive format not supported.");
+        buffer = m_cache->get(identity, file.data_offset);
+        if (buffer) {
+            result.status = evp_result::status::ok;
             return result;
         }
-
-        format->read_file_desc_block(stream);
-    }
-    catch (const std::exception& e) {
-        result.message = EVP_STR_FORMAT("read_structure() ex | {}", e.what());
-        return result;
     }
 
-    result.status = evp_result::status::ok;
-    return result;
-}
-
-evp_result determine_format(fstream_read& stream, std::shared_ptr<libevp::format::format>& format) {
-    evp_result result;
-    result.status = evp_result::status::failure;
+    auto decoded = std::make_shared<buffer_t>();
 
-    std::shared_ptr<libevp::format::format> supported_formats[] = {
-        static_pointer_cast<libevp::format::format>(std::make_shared<libevp::format::v1::format>()),
-        static_pointer_cast<libevp::format::format>(std::make_shared<libevp::format::v2::format>()),
-    };
+    res = read_file(evp_source::from_file(input), file, *decoded);
+    if (!res)
+        return res;
 
-    for (std::shared_ptr<libevp::format::format> supported_format : supported_formats) {
-        if (!supported_format) continue;
-        
-        supported_format->read_format_desc(stream);
-        
-        if (supported_format->is_valid) {
-            format = supported_format;
+    buffer = decoded;
 
-            result.status = evp_result::status::ok;
-            return result;
-        }
-    }
+    if (m_cache)
+        m_cache->put(identity, file.data_offset, buffer);
 
+    result.status = evp_result::status::ok;
     return result;
 }
 
-evp_result validate_evp_archive(const FILE_PATH& input, bool existing) {
-    evp_result result;
+evp_result evp::get_file(const FILE_PATH& input, const FILE_PATH& file, std::vector<uint8_t>& buffer) {
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    res = validate_evp_archive(input, true);
+    if (!res) {
+        result.message = res.message;
+        return result;
+    }
+
+    std::string name     = to_fd_name(file);
+    std::string identity = "";
+
+    // cached entries are found by name without parsing the archive
+    if (m_cache) {
+        try {
+            identity = get_archive_identity(input);
+        }
+        catch (const std::exception& e) {
+            result.message = e.what();
+            return result;
+        }
+
+        auto cached = m_cache->get(identity, name);
+        if (cached) {
+            buffer.assign(cached->begin(), cached->end());
+
+            result.status = evp_result::status::ok;
+            return result;
+        }
+    }
+
+    source_read stream(evp_source::from_file(input));
+    if (!stream.is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
+        return result;
+    }
+
+    format::format::ptr_t format;
+    res = read_structure(stream, format);
+    if (!res) {
+        result.message = res.message;
+        return result;
+    }
+
+    for (evp_fd_view fd : format->desc_block->files) {
+        if (fd.file != name) continue;
+
+        try {
+            if (m_cache) {
+                auto decoded = std::make_shared<buffer_t>();
+                decode_file(stream, format, fd, *decoded);
+
+                buffer.assign(decoded->begin(), decoded->end());
+                m_cache->put(identity, fd.data_offset, std::move(decoded), name);
+            }
+            else {
+                decode_file(stream, format, fd, buffer);
+            }
+        }
+        catch (const std::exception& e) {
+            result.message = e.what();
+            return result;
+        }
+
+        result.status = evp_result::status::ok;
+        return result;
+    }
+
+    result.message = EVP_STR_FORMAT("File not found.");
+    return result;
+}
+
+evp_result evp::get_files(const FILE_PATH& input, const std::vector<evp_fd>& files,
+    std::vector<evp_cache::buffer_ptr_t>& buffers)
+{
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    res = validate_evp_archive(input, true);
+    if (!res) {
+        result.message = res.message;
+        return result;
+    }
+
+    source_read stream(evp_source::from_file(input));
+    if (!stream.is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
+        return result;
+    }
+
+    buffers.assign(files.size(), nullptr);
+
+    try {
+        std::string identity = m_cache ? get_archive_identity(input) : "";
+
+        format::format::ptr_t format;
+
+        res = determine_format(stream, format);
+        if (!res || !format) {
+            result.message = EVP_STR_FORMAT("Archive format not supported.");
+            return result;
+        }
+
+        for (size_t i = 0; i < files.size(); i++) {
+            if (m_cache) {
+                buffers[i] = m_cache->get(identity, files[i].data_offset);
+                if (buffers[i]) continue;
+            }
+
+            auto decoded = std::make_shared<buffer_t>();
+            decode_file(stream, format, files[i], *decoded);
+
+            buffers[i] = decoded;
+
+            if (m_cache)
+                m_cache->put(identity, files[i].data_offset, buffers[i]);
+        }
+    }
+    catch (const std::exception& e) {
+        result.message = e.what();
+        return result;
+    }
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_result evp::get_file(const FILE_PATH& input, const FILE_PATH& file, std::stringstream& stream) {
+    buffer_t buffer;
+
+    auto result = get_file(input, file, buffer);
+    if (!result)
+        return result;
+
+    std::move(buffer.begin(), buffer.end(), std::ostream_iterator<unsigned char>(stream));
+
+    return result;
+}
+
+evp_result evp::get_file(const evp_source::ptr_t& input, const evp_fd& file, std::vector<uint8_t>& buffer) {
+    return read_file(input, file, buffer);
+}
+
+evp_result evp::get_file(const evp_source::ptr_t& input, const FILE_PATH& file, std::vector<uint8_t>& buffer) {
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    source_read stream(input);
+    if (!stream.is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
+        return result;
+    }
+
+    format::format::ptr_t format;
+    res = read_structure(stream, format);
+    if (!res) {
+        result.message = res.message;
+        return result;
+    }
+
+    std::string name = to_fd_name(file);
+
+    for (evp_fd_view fd : format->desc_block->files) {
+        if (fd.file != name) continue;
+
+        try {
+            decode_file(stream, format, fd, buffer);
+        }
+        catch (const std::exception& e) {
+            result.message = e.what();
+            return result;
+        }
+
+        result.status = evp_result::status::ok;
+        return result;
+    }
+
+    result.message = EVP_STR_FORMAT("File not found.");
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+evp_result read_structure(source_read& stream, libevp::format::format::ptr_t& format,
+    const evp_context_internal* context)
+{
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    evp_stats* stats = context ? context->get_stats() : nullptr;
+    evp_trace* trace = context ? context->get_trace() : nullptr;
+
+    stats_timer timer(stats, evp_stats::phase::parse);
+
+    try {
+        evp_result res;
+        {
+            trace_span span(trace, "determine_format", "parse");
+            res = determine_format(stream, format);
+        }
+
+        if (!res) {
+            result.message = EVP_STR_FORMAT("Archive format not supported.");
+            return result;
+        }
+
+        if (!format) {
+            result.message = EVP_STR_FORMAT("Archive format not supported.");
+            return result;
+        }
+
+        trace_span span(trace, "read_file_desc_block", "parse");
+        format->read_file_desc_block(stream);
+    }
+    catch (const std::exception& e) {
+        result.message = EVP_STR_FORMAT("read_structure() ex | {}", e.what());
+        return result;
+    }
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_result determine_format(source_read& stream, std::shared_ptr<libevp::format::format>& format) {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    std::shared_ptr<libevp::format::format> supported_formats[] = {
+        static_pointer_cast<libevp::format::format>(std::make_shared<libevp::format::v1::format>()),
+        static_pointer_cast<libevp::format::format>(std::make_shared<libevp::format::v2::format>()),
+    };
+
+    for (std::shared_ptr<libevp::format::format> supported_format : supported_formats) {
+        if (!supported_format) continue;
+        
+        supported_format->read_format_desc(stream);
+        
+        if (supported_format->is_valid) {
+            format = supported_format;
+
+            result.status = evp_result::status::ok;
+            return result;
+        }
+    }
+
+    return result;
+}
+
+evp_result validate_evp_archive(const FILE_PATH& input, bool existing) {
+    evp_result result;
     result.status = evp_result::status::failure;
 
     try {
@@ -416,85 +908,402 @@ evp_result validate_directory(const DIR_PATH& input) {
             return result;
         }
 
-        if (!std::filesystem::is_directory(input)) {
-            result.message = "Not a directory.";
-            return result;
+        if (!std::filesystem::is_directory(input)) {
+            result.message = "Not a directory.";
+            return result;
+        }
+    }
+    catch (const std::exception& e) {
+        result.message = e.what();
+        return result;
+    }
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_result read_file(const evp_source::ptr_t& input, const evp_fd& file, buffer_t& buffer) {
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    source_read stream(input);
+    if (!stream.is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
+        return result;
+    }
+
+    try {
+        format::format::ptr_t format;
+
+        res = determine_format(stream, format);
+        if (!res || !format) {
+            result.message = EVP_STR_FORMAT("Archive format not supported.");
+            return result;
+        }
+
+        decode_file(stream, format, file, buffer);
+    }
+    catch (const std::exception& e) {
+        result.message = e.what();
+        return result;
+    }
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+void decode_file(source_read& stream, libevp::format::format::ptr_t& format, const evp_fd_view& file,
+    buffer_t& buffer)
+{
+    buffer.clear();
+    buffer.reserve(file.data_size);
+
+    format->read_file_data(stream, file, [&](const uint8_t* data, uint32_t size) {
+        buffer.insert(buffer.end(), data, data + size);
+    });
+}
+
+void fail_job(evp_job::state& state, evp_context_internal& context, std::string message) {
+    evp_result result;
+    result.status  = evp_result::status::failure;
+    result.message = std::move(message);
+
+    // finish callback may be what threw, the job has to finish regardless
+    try {
+        context.invoke_finish(result);
+    }
+    catch (...) {}
+
+    state.set_finished(result);
+}
+
+std::string get_archive_identity(const FILE_PATH& input) {
+    // lexical only, resolving links would cost more syscalls on every lookup
+    FILE_PATH path = std::filesystem::absolute(input).lexically_normal();
+
+    auto size = std::filesystem::file_size(path);
+    auto time = std::filesystem::last_write_time(path).time_since_epoch().count();
+
+    return EVP_STR_FORMAT("{}|{}|{}", path.string(), size, (int64_t)time);
+}
+
+std::vector<size_t> get_layout_order(const std::vector<evp::pack_entry>& entries,
+    std::vector<evp_access_record> trace)
+{
+    std::vector<size_t> order;
+    order.reserve(entries.size());
+
+    if (trace.empty()) {
+        for (size_t i = 0; i < entries.size(); i++) {
+            order.push_back(i);
+        }
+
+        return order;
+    }
+
+    std::vector<std::string>                     names(entries.size());
+    std::unordered_map<std::string_view, size_t> by_name;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        names[i] = to_fd_name(entries[i].file);
+        by_name.emplace(names[i], i);
+    }
+
+    // traces merged from several clients or threads are ordered by time when it's known
+    bool timed = std::any_of(trace.begin(), trace.end(), [](const evp_access_record& record) {
+        return record.time != 0U;
+    });
+
+    if (timed) {
+        std::stable_sort(trace.begin(), trace.end(), [](const evp_access_record& a, const evp_access_record& b) {
+            return a.time < b.time;
+        });
+    }
+
+    std::vector<bool> placed(entries.size(), false);
+
+    for (const evp_access_record& record : trace) {
+        auto it = by_name.find(to_fd_name(record.file));
+        if (it == by_name.end() || placed[it->second])
+            continue;
+
+        order.push_back(it->second);
+        placed[it->second] = true;
+    }
+
+    // directories are ranked by first appearance so the rest keeps input order otherwise
+    std::unordered_map<std::string_view, size_t> dir_ranks;
+    std::vector<size_t>                          ranks(entries.size(), 0U);
+    std::vector<size_t>                          rest;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (placed[i])
+            continue;
+
+        std::string_view name = names[i];
+        size_t           sep  = name.find_last_of('/');
+        std::string_view dir  = sep == std::string_view::npos ? std::string_view() : name.substr(0, sep);
+
+        ranks[i] = dir_ranks.emplace(dir, dir_ranks.size()).first->second;
+        rest.push_back(i);
+    }
+
+    std::stable_sort(rest.begin(), rest.end(), [&](size_t a, size_t b) {
+        return ranks[a] < ranks[b];
+    });
+
+    order.insert(order.end(), rest.begin(), rest.end());
+    return order;
+}
+
+void MD5_hex_string_to_bytes(MD5& md5, uint8_t* bytes) {
+    std::string hex_bytes = md5.getHash();
+
+    for (size_t i = 0; i < hex_bytes.size(); i += 2) {
+        uint8_t high = std::isdigit(hex_bytes[i])     ? (hex_bytes[i]     - '0') : (std::toupper(hex_bytes[i])     - 'A' + 10);
+        uint8_t low  = std::isdigit(hex_bytes[i + 1]) ? (hex_bytes[i + 1] - '0') : (std::toupper(hex_bytes[i + 1]) - 'A' + 10);
+
+        bytes[i / 2] = (high << 4) | low;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// EVP IMPL
+
+evp_result evp_impl::pack_impl(const evp::pack_input input, FILE_PATH output,
+    evp_context_internal& context)
+{
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // VERIFY
+
+    if (!output.is_absolute())
+        output = std::filesystem::absolute(output);
+
+    res = validate_directory(input.base);
+    if (!res) {
+        result.message = EVP_STR_FORMAT("Failed to validate input base path. | {}", res.message);
+
+        context.invoke_finish(result);
+        return result;
+    }
+
+    res = validate_evp_archive(output, false);
+    if (!res) {
+        result.message = EVP_STR_FORMAT("Failed to validate output archive path. | {}", res.message);
+
+        context.invoke_finish(result);
+        return result;
+    }
+
+    /*
+        Entries of the previous archive by name. Unchanged files whose cached hash
+        matches the entry are copied from it instead, which lets filesystems share extents.
+        Ignored when missing or when it's the archive being written.
+    */
+
+    std::error_code ec;
+
+    source_read                                       previous_stream(nullptr);
+    format::format::ptr_t                             previous_format;
+    std::unordered_map<std::string_view, evp_fd_view> previous_fds;
+
+    if (input.hash_cache && !input.previous_archive.empty() && std::filesystem::is_regular_file(input.previous_archive, ec) &&
+        !std::filesystem::equivalent(input.previous_archive, output, ec))
+    {
+        previous_stream = source_read(evp_source::from_file(input.previous_archive));
+
+        if (previous_stream.is_valid() && read_structure(previous_stream, previous_format)) {
+            for (evp_fd_view fd : previous_format->desc_block->files) {
+                previous_fds.emplace(fd.file, fd);
+            }
+        }
+    }
+
+    evp::pack_source_input source_input;
+    source_input.preallocate         = input.preallocate;
+    source_input.access_trace        = input.access_trace;
+    source_input.alignment           = input.alignment;
+    source_input.alignment_threshold = input.alignment_threshold;
+    source_input.entries.reserve(input.files.size());
+
+    std::vector<evp_hash_cache::stamp> stamps(input.files.size());
+    std::vector<bool>                  stamped(input.files.size(), false);
+
+    for (size_t i = 0; i < input.files.size(); i++) {
+        const auto& relative_file = input.files[i];
+
+        std::filesystem::path file = input.base;
+        file /= relative_file;
+
+        if (!std::filesystem::exists(file)) {
+            result.message = EVP_STR_FORMAT("`{}` | File not found.", file.string().c_str());
+
+            context.invoke_finish(result);
+            return result;
+        }
+
+        // opened when packed
+        evp::pack_entry entry = { relative_file.string(), evp_source::from_file(file) };
+
+        // stamp is taken before packing so files changed meanwhile miss next time
+        if (input.hash_cache && evp_hash_cache::read_stamp(file, stamps[i])) {
+            stamped[i] = true;
+
+            evp_hash_cache::hash_t hash = {};
+            if (input.hash_cache->get(file, stamps[i], hash)) {
+                entry.hash = hash;
+
+                auto it = previous_fds.find(to_fd_name(entry.file));
+                if (it != previous_fds.end()) {
+                    const evp_fd_view& fd = it->second;
+
+                    if (fd.data_size == stamps[i].size && memcmp(fd.hash, hash.data(), hash.size()) == 0 &&
+                        previous_format->is_stored(previous_stream, fd))
+                    {
+                        entry.source = evp_source::from_file_range(input.previous_archive, fd.data_offset, fd.data_size);
+                    }
+                }
+            }
         }
+
+        source_input.entries.push_back(std::move(entry));
     }
-    catch (const std::exception& e) {
-        result.message = e.what();
+
+    auto sink = evp_sink::from_file(output);
+    if (!sink->is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open output archive file for writing.");
+
+        context.invoke_finish(result);
         return result;
     }
 
-    result.status = evp_result::status::ok;
-    return result;
-}
+    std::vector<evp_hash_cache::hash_t> hashes;
 
-void MD5_hex_string_to_bytes(MD5& md5, uint8_t* bytes) {
-    std::string hex_bytes = md5.getHash();
+    result = pack_impl(std::move(source_input), sink, context, &hashes);
+    if (!result || !input.hash_cache)
+        return result;
 
-    for (size_t i = 0; i < hex_bytes.size(); i += 2) {
-        uint8_t high = std::isdigit(hex_bytes[i])     ? (hex_bytes[i]     - '0') : (std::toupper(hex_bytes[i])     - 'A' + 10);
-        uint8_t low  = std::isdigit(hex_bytes[i + 1]) ? (hex_bytes[i + 1] - '0') : (std::toupper(hex_bytes[i + 1]) - 'A' + 10);
+    for (size_t i = 0; i < input.files.size(); i++) {
+        if (!stamped[i])
+            continue;
 
-        bytes[i / 2] = (high << 4) | low;
+        std::filesystem::path file = input.base;
+        file /= input.files[i];
+
+        input.hash_cache->set(file, stamps[i], hashes[i]);
     }
-}
 
-///////////////////////////////////////////////////////////////////////////////
-// EVP IMPL
+    return result;
+}
 
-evp_result evp_impl::pack_impl(const evp::pack_input input, FILE_PATH output,
-    evp_context_internal& context)
+evp_result evp_impl::pack_impl(evp::pack_source_input input, evp_sink::ptr_t output,
+    evp_context_internal& context, std::vector<evp_hash_cache::hash_t>* hashes)
 {
-    evp_result result, res;
+    evp_result result;
     result.status = evp_result::status::failure;
 
     ///////////////////////////////////////////////////////////////////////////
-    // VERIFY
-
-    if (!output.is_absolute())
-        output = std::filesystem::absolute(output);
+    // PACK
 
-    res = validate_directory(input.base);
-    if (!res) {
-        result.message = EVP_STR_FORMAT("Failed to validate input base path. | {}", res.message);
+    if ((input.alignment & (input.alignment - 1U)) != 0U) {
+        result.message = EVP_STR_FORMAT("Alignment must be a power of two.");
 
         context.invoke_finish(result);
         return result;
     }
 
-    res = validate_evp_archive(output, false);
-    if (!res) {
-        result.message = EVP_STR_FORMAT("Failed to validate output archive path. | {}", res.message);
+    format::v1::format format;
+
+    sink_write stream(output, EVP_WRITE_BUFFER_SIZE);
+    if (!stream.is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open output for writing.");
 
         context.invoke_finish(result);
         return result;
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    // PACK
+    // PLAN
 
-    format::v1::format format;
+    /*
+        Entry sizes are known up front, so the whole layout is computed before
+        writing and the archive is written strictly front to back.
+    */
 
-    fstream_write stream(output);
-    if (!stream.is_valid()) {
-        result.message = EVP_STR_FORMAT("Failed to open output archive file for writing.");
+    // lay entries out in the order clients read them
+    std::vector<size_t> order = get_layout_order(input.entries, std::move(input.access_trace));
 
-        context.invoke_finish(result);
-        return result;
+    if (!std::is_sorted(order.begin(), order.end())) {
+        std::vector<evp::pack_entry> ordered;
+        ordered.reserve(order.size());
+
+        for (size_t i : order) {
+            ordered.push_back(std::move(input.entries[i]));
+        }
+
+        input.entries = std::move(ordered);
+    }
+
+    float    prog_change = 100.0f / input.entries.size();
+    uint64_t prog_total  = 0U;
+
+    format.desc_block->files.reserve(input.entries.size());
+
+    for (auto& entry : input.entries) {
+        if (!entry.source || !entry.source->is_valid()) {
+            result.message = EVP_STR_FORMAT("`{}` | Failed to open file for reading.", entry.file);
+
+            context.invoke_finish(result);
+            return result;
+        }
+
+        evp_fd fd;
+        fd.file      = entry.file;
+        fd.data_size = entry.source->size();
+
+        // Swap slash direction
+        std::replace(fd.file.begin(), fd.file.end(), '/', '\\');
+
+        // Remove leading slash
+        if (!fd.file.empty() && fd.file[0] == '\\')
+            fd.file.erase(0, 1);
+
+        prog_total += fd.data_size;
+        format.desc_block->files.push_back(fd);
     }
 
-    float prog_change = 100.0f / input.files.size();
+    format.plan_layout(input.alignment, input.alignment_threshold);
+
+    if (input.preallocate)
+        stream.preallocate(format.file_desc_block_offset + format.file_desc_block_size);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // WRITE
 
+    context.set_progress_total(prog_total);
     context.invoke_start();
 
+    evp_stats* stats = context.get_stats();
+    evp_trace* trace = context.get_trace();
+
     buffer_t buffer{};
     buffer.resize(EVP_READ_CHUNK_SIZE);
 
+    // zeroes written in front of aligned entries
+    buffer_t padding{};
+    padding.resize(input.alignment);
+
     format.write_format_desc(stream);
 
-    for (const auto& relative_file : input.files) {
+    if (hashes)
+        hashes->resize(input.entries.size());
+
+    for (size_t i = 0; i < input.entries.size(); i++) {
+        auto& entry = input.entries[i];
+
         if (context.is_cancelled()) {
             context.invoke_cancel();
 
@@ -502,68 +1311,151 @@ evp_result evp_impl::pack_impl(const evp::pack_input input, FILE_PATH output,
             return result;
         }
 
-        std::filesystem::path file = input.base;
-        file /= relative_file;
+        evp_fd_view fd = format.desc_block->files[i];
 
-        if (!std::filesystem::exists(file)) {
-            result.message = EVP_STR_FORMAT("`{}` | File not found.", file.string().c_str());
+        if (stream.pos() < fd.data_offset) {
+            size_t size = (size_t)(fd.data_offset - stream.pos());
+            stream.write(padding.data(), size);
 
-            context.invoke_finish(result);
-            return result;
+            if (stats)
+                stats->add_bytes_written(size);
         }
 
-        fstream_read read_stream(file);
-        if (!read_stream.is_valid()) {
-            result.message = EVP_STR_FORMAT("`{}` | Failed to open file for reading.", file.string().c_str());
+        stats_timer entry_timer(stats);
+        trace_span  entry_span(trace, "entry", "entry", fd.data_offset, fd.file);
 
-            context.invoke_finish(result);
-            return result;
-        }
+        /*
+            Data of entries with a known hash doesn't have to pass through memory,
+            copy it inside the kernel if both source and sink are files.
+        */
 
-        evp_fd fd;
-        fd.file        = relative_file.string();
-        fd.data_offset = (uint32_t)stream.pos();
-        fd.data_size   = (uint32_t)read_stream.size();
+        FILE_PATH extent_file;
+        uint64_t  extent_offset = 0U;
+        uint64_t  copied        = 0U;
+        bool      copy          = entry.hash && entry.source->get_file_extent(extent_file, extent_offset);
 
-        // Swap slash direction
-        std::replace(fd.file.begin(), fd.file.end(), '/', '\\');
+        while (copy && copied < fd.data_size) {
+            if (context.is_cancelled()) {
+                context.invoke_cancel();
 
-        // Remove leading slash
-        if (fd.file[0] == '\\')
-            fd.file.erase(0, 1);
+                result.status = evp_result::status::cancelled;
+                return result;
+            }
+
+            uint64_t size = std::min<uint64_t>(fd.data_size - copied, EVP_COPY_CHUNK_SIZE);
+
+            {
+                stats_timer timer(stats, evp_stats::phase::write);
+                trace_span  span(trace, "copy", "io", fd.data_offset);
+
+                copy = stream.copy_from(extent_file, extent_offset + copied, size);
+            }
+
+            if (!copy) {
+                if (copied == 0U)
+                    break;
+
+                result.message = EVP_STR_FORMAT("`{}` | Failed to copy file data.", entry.file);
+
+                context.invoke_finish(result);
+                return result;
+            }
+
+            if (stats) {
+                stats->add_bytes_read(size);
+                stats->add_bytes_written(size);
+            }
+
+            copied += size;
+            context.add_progress(size);
+        }
+
+        source_read read_stream(entry.source);
 
         MD5      md5;
-        uint32_t left_to_read = fd.data_size;
+        uint64_t left_to_read = copy ? 0U : fd.data_size;
 
         while (left_to_read > 0) {
-            // read file chunk
-            uint32_t read_count = (uint32_t)std::min(left_to_read, EVP_READ_CHUNK_SIZE);
-            read_stream.read(buffer.data(), read_count);
+            if (context.is_cancelled()) {
+                context.invoke_cancel();
+
+                result.status = evp_result::status::cancelled;
+                return result;
+            }
+
+            // read file chunk, in-memory sources aren't copied
+            uint32_t       read_count = (uint32_t)std::min<uint64_t>(left_to_read, EVP_READ_CHUNK_SIZE);
+            const uint8_t* data       = nullptr;
+            {
+                trace_span span(trace, "read", "io", fd.data_offset);
+
+                data = read_stream.view(read_count);
+                if (!data) {
+                    read_stream.read(buffer.data(), read_count);
+                    data = buffer.data();
+                }
+            }
             
             // write file chunk to archive
-            stream.write(buffer.data(), read_count);
+            {
+                stats_timer timer(stats, evp_stats::phase::write);
+                trace_span  span(trace, "write", "io", fd.data_offset);
+                stream.write(data, read_count);
+            }
+
+            // compute chunk MD5, skipped when known
+            if (!entry.hash) {
+                stats_timer timer(stats, evp_stats::phase::md5);
+                trace_span  span(trace, "md5", "codec", fd.data_offset);
+                md5.add(data, read_count);
+            }
 
-            // compute chunk MD5
-            md5.add(buffer.data(), read_count);
+            if (stats) {
+                stats->add_bytes_read(read_count);
+                stats->add_bytes_written(read_count);
+            }
 
             left_to_read -= read_count;
+            context.add_progress(read_count);
         }
 
+        // release file handles as we go
+        entry.source.reset();
+
         // compute file MD5
-        MD5_hex_string_to_bytes(md5, fd.hash.data());
+        if (!entry.hash) {
+            stats_timer timer(stats, evp_stats::phase::md5);
+
+            entry.hash.emplace();
+            MD5_hex_string_to_bytes(md5, entry.hash->data());
+        }
+
+        format.desc_block->files.set_hash(i, entry.hash->data());
+
+        // hashes are returned in input order
+        if (hashes)
+            (*hashes)[order[i]] = *entry.hash;
+
+        if (stats)
+            stats->add_entry(fd.data_offset, fd.data_size, entry_timer.elapsed());
 
-        format.desc_block->files.push_back(fd);
         context.invoke_update(prog_change);
     }
 
-    format.file_desc_block_offset = (uint32_t)stream.pos();
-    format.file_count             = (uint64_t)format.desc_block->files.size();
-    
+    if (stream.pos() != format.file_desc_block_offset) {
+        result.message = EVP_STR_FORMAT("Written data doesn't match planned layout.");
+
+        context.invoke_finish(result);
+        return result;
+    }
+
     format.write_file_desc_block(stream);
-    format.write_format_desc(stream);
+    stream.flush();
 
     result.status = evp_result::status::ok;
 
+    context.flush_progress();
+
     context.invoke_finish(result);
     return result;
 }
@@ -599,7 +1491,7 @@ evp_result evp_impl::unpack_impl(evp::unpack_input input, DIR_PATH output,
         return result;
     }
 
-    std::unordered_set<uint32_t> requested_fds = {};
+    std::unordered_set<uint64_t> requested_fds = {};
     for (evp_fd& fd : input.files) {
         requested_fds.insert(fd.data_offset);
     }
@@ -607,7 +1499,7 @@ evp_result evp_impl::unpack_impl(evp::unpack_input input, DIR_PATH output,
     ///////////////////////////////////////////////////////////////////////////
     // UNPACK
 
-    fstream_read stream(input.archive);
+    source_read stream(evp_source::from_file(input.archive));
     if (!stream.is_valid()) {
         result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
 
@@ -615,8 +1507,11 @@ evp_result evp_impl::unpack_impl(evp::unpack_input input, DIR_PATH output,
         return result;
     }
 
+    evp_stats* stats = context.get_stats();
+    evp_trace* trace = context.get_trace();
+
     format::format::ptr_t format;
-    res = read_structure(stream, format);
+    res = read_structure(stream, format, &context);
     if (!res) {
         result.message = res.message;
 
@@ -624,11 +1519,30 @@ evp_result evp_impl::unpack_impl(evp::unpack_input input, DIR_PATH output,
         return result;
     }
 
-    float prog_change = 100.0f / format->file_count;
+    format->context = &context;
+
+    float    prog_change = 100.0f / format->file_count;
+    uint64_t prog_total  = 0U;
+
+    for (evp_fd_view fd : format->desc_block->files) {
+        if (requested_fds.size() == 0 || requested_fds.contains(fd.data_offset))
+            prog_total += fd.data_size;
+    }
+
+    extract_writer writer(output, EVP_WRITE_BUFFER_SIZE);
+    if (!writer.is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open output directory for writing.");
+
+        context.invoke_finish(result);
+        return result;
+    }
+
+    bool zero_copy = input.zero_copy && writer.set_source(input.archive);
 
+    context.set_progress_total(prog_total);
     context.invoke_start();
 
-    for (evp_fd& fd : format->desc_block->files) {
+    for (evp_fd_view fd : format->desc_block->files) {
         if (context.is_cancelled()) {
             context.invoke_cancel();
 
@@ -641,33 +1555,251 @@ evp_result evp_impl::unpack_impl(evp::unpack_input input, DIR_PATH output,
             continue;
         }
 
-        std::filesystem::path dir_path(output);
-        dir_path /= fd.file;
-        dir_path.remove_filename();
+        stats_timer entry_timer(stats);
+        trace_span  entry_span(trace, "entry", "entry", fd.data_offset, fd.file);
 
-        std::filesystem::path file_path(output);
-        file_path /= fd.file;
+        if (!writer.open(fd.file, fd.data_size)) {
+            std::filesystem::path file_path(output);
+            file_path /= fd.file;
 
-        if (!std::filesystem::is_directory(dir_path)) {
-            std::filesystem::create_directories(dir_path);
-            std::filesystem::permissions(dir_path, std::filesystem::perms::all);
+            result.message = EVP_STR_FORMAT("`{}` | Failed to open file for writing.", file_path.string().c_str());
+            return result;
         }
 
-        fstream_write out_stream(file_path);
-        if (!out_stream.is_valid()) {
-            result.message = EVP_STR_FORMAT("`{}` | Failed to open file for writing.", file_path.string().c_str());
+        try {
+            // stored entries are copied inside the kernel while it's supported
+            bool     copy   = zero_copy && format->is_stored(stream, fd);
+            uint64_t copied = 0U;
+
+            while (copy && copied < fd.data_size) {
+                format->check_cancelled();
+
+                uint64_t size = std::min<uint64_t>(fd.data_size - copied, EVP_COPY_CHUNK_SIZE);
+
+                {
+                    stats_timer timer(stats, evp_stats::phase::write);
+                    trace_span  span(trace, "copy", "io", fd.data_offset);
+
+                    copy = writer.copy(fd.data_offset + copied, size);
+                }
+
+                if (!copy) {
+                    if (copied != 0U)
+                        throw std::runtime_error("Failed to write requested size.");
+
+                    zero_copy = false;
+                    break;
+                }
+
+                if (stats) {
+                    stats->add_bytes_read(size);
+                    stats->add_bytes_written(size);
+                }
+
+                context.add_progress(size);
+                copied += size;
+            }
+
+            if (!copy) {
+                format->read_file_data(stream, fd, [&](const uint8_t* data, uint32_t size) {
+                    {
+                        stats_timer timer(stats, evp_stats::phase::write);
+                        trace_span  span(trace, "write", "io", fd.data_offset);
+                        writer.write(data, size);
+                    }
+
+                    if (stats)
+                        stats->add_bytes_written(size);
+
+                    context.add_progress(size);
+                });
+            }
+
+            stats_timer timer(stats, evp_stats::phase::write);
+            writer.close();
+        }
+        catch (const evp_cancelled_exception&) {
+            context.invoke_cancel();
+
+            result.status = evp_result::status::cancelled;
             return result;
         }
 
-        format->read_file_data(stream, fd, [&](uint8_t* data, uint32_t size) {
-            out_stream.write(data, size);
-        });
+        if (stats)
+            stats->add_entry(fd.data_offset, fd.data_size, entry_timer.elapsed());
+
+        context.invoke_update(prog_change);
+    }
+
+    result.status = evp_result::status::ok;
+
+    context.flush_progress();
+    context.invoke_finish(result);
+    return result;
+}
+
+evp_result evp_impl::transcode_impl(const evp::transcode_input& input, evp_sink::ptr_t output,
+    evp_context_internal& context)
+{
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // VERIFY
+
+    source_read stream(input.archive);
+    if (!stream.is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open input archive for reading.");
+
+        context.invoke_finish(result);
+        return result;
+    }
+
+    sink_write out_stream(output, EVP_WRITE_BUFFER_SIZE);
+    if (!out_stream.is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to open output for writing.");
+
+        context.invoke_finish(result);
+        return result;
+    }
+
+    format::format::ptr_t in_format;
+    res = read_structure(stream, in_format, &context);
+    if (!res) {
+        result.message = res.message;
+
+        context.invoke_finish(result);
+        return result;
+    }
+
+    in_format->context = &context;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PLAN
+
+    format::v1::format format;
+    auto               block = static_pointer_cast<format::v1::file_desc_block>(format.desc_block);
+
+    if (dynamic_pointer_cast<format::v1::format>(in_format)) {
+        auto in_block = static_pointer_cast<format::v1::file_desc_block>(in_format->desc_block);
+        block->region_name = in_block->region_name;
+        block->_unk_1      = in_block->_unk_1;
+        block->_unk_2      = in_block->_unk_2;
+        block->_unk_3      = in_block->_unk_3;
+    }
+    else if (dynamic_pointer_cast<format::v2::format>(in_format)) {
+        auto in_block = static_pointer_cast<format::v2::file_desc_block>(in_format->desc_block);
+        block->region_name = in_block->region_name;
+        block->_unk_1      = in_block->_unk_1;
+        block->_unk_2      = in_block->_unk_2;
+        block->_unk_3      = in_block->_unk_3;
+    }
+
+    const entry_table& in_files = in_format->desc_block->files;
+
+    float    prog_change = 100.0f / in_files.size();
+    uint64_t prog_total  = 0U;
+
+    block->files.reserve(in_files.size());
+
+    for (evp_fd_view in_fd : in_files) {
+        evp_fd fd = in_fd.to_fd();
+
+        // readers swap slash direction, swap it back
+        std::replace(fd.file.begin(), fd.file.end(), '/', '\\');
+
+        prog_total += fd.data_size;
+        block->files.push_back(fd);
+    }
+
+    format.plan_layout();
+
+    if (input.preallocate)
+        out_stream.preallocate(format.file_desc_block_offset + format.file_desc_block_size);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // WRITE
+
+    context.set_progress_total(prog_total);
+    context.invoke_start();
+
+    evp_stats* stats = context.get_stats();
+    evp_trace* trace = context.get_trace();
+
+    format.write_format_desc(out_stream);
+
+    for (size_t i = 0; i < in_files.size(); i++) {
+        evp_fd_view in_fd = in_files[i];
+        evp_fd_view fd    = block->files[i];
+
+        MD5      md5;
+        uint64_t written = 0U;
+
+        stats_timer entry_timer(stats);
+        trace_span  entry_span(trace, "entry", "entry", in_fd.data_offset, in_fd.file);
+
+        try {
+            in_format->check_cancelled();
+
+            in_format->read_file_data(stream, in_fd, [&](const uint8_t* data, uint32_t size) {
+                if (written + size > fd.data_size)
+                    throw evp_exception("Entry data larger than its descriptor.");
+
+                {
+                    stats_timer timer(stats, evp_stats::phase::write);
+                    trace_span  span(trace, "write", "io", fd.data_offset);
+                    out_stream.write(data, size);
+                }
+
+                if (input.recompute_hashes) {
+                    stats_timer timer(stats, evp_stats::phase::md5);
+                    trace_span  span(trace, "md5", "codec", fd.data_offset);
+                    md5.add(data, size);
+                }
+
+                if (stats)
+                    stats->add_bytes_written(size);
+
+                written += size;
+                context.add_progress(size);
+            });
+        }
+        catch (const evp_cancelled_exception&) {
+            context.invoke_cancel();
+
+            result.status = evp_result::status::cancelled;
+            return result;
+        }
+
+        if (written != fd.data_size) {
+            result.message = EVP_STR_FORMAT("`{}` | Entry data doesn't match its descriptor.", in_fd.file);
+
+            context.invoke_finish(result);
+            return result;
+        }
+
+        if (input.recompute_hashes) {
+            stats_timer timer(stats, evp_stats::phase::md5);
+
+            std::array<uint8_t, 16> hash = {};
+            MD5_hex_string_to_bytes(md5, hash.data());
+
+            block->files.set_hash(i, hash.data());
+        }
+
+        if (stats)
+            stats->add_entry(fd.data_offset, fd.data_size, entry_timer.elapsed());
 
         context.invoke_update(prog_change);
     }
 
+    format.write_file_desc_block(out_stream);
+    out_stream.flush();
+
     result.status = evp_result::status::ok;
 
+    context.flush_progress();
+
     context.invoke_finish(result);
     return result;
 }
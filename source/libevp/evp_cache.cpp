@@ -0,0 +1,119 @@
+#include "libevp/evp_cache.hpp"
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+evp_cache::evp_cache(uint64_t budget) {
+    m_stats.budget = budget;
+}
+
+evp_cache::buffer_ptr_t evp_cache::get(const std::string& archive, uint64_t offset) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto it = m_map.find(key{ archive, offset });
+    if (it == m_map.end()) {
+        m_stats.misses++;
+        return nullptr;
+    }
+
+    // move to front
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+
+    m_stats.hits++;
+    return it->second->buffer;
+}
+
+evp_cache::buffer_ptr_t evp_cache::get(const std::string& archive, const std::string& file) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto it = m_names.find(name_key{ archive, file });
+    if (it == m_names.end()) {
+        m_stats.misses++;
+        return nullptr;
+    }
+
+    // move to front
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+
+    m_stats.hits++;
+    return it->second->buffer;
+}
+
+void evp_cache::put(const std::string& archive, uint64_t offset, buffer_ptr_t buffer, const std::string& file) {
+    if (!buffer) return;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (buffer->size() > m_stats.budget)
+        return;
+
+    key k{ archive, offset };
+
+    auto it = m_map.find(k);
+    if (it != m_map.end()) {
+        m_stats.size -= it->second->buffer->size();
+        m_stats.size += buffer->size();
+
+        it->second->buffer = std::move(buffer);
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+    }
+    else {
+        m_stats.size += buffer->size();
+
+        m_lru.push_front(entry{ k, std::move(buffer) });
+        m_map.emplace(std::move(k), m_lru.begin());
+    }
+
+    if (!file.empty() && m_names.emplace(name_key{ archive, file }, m_lru.begin()).second)
+        m_lru.front().names.push_back(file);
+
+    evict();
+}
+
+void evp_cache::clear() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    m_map.clear();
+    m_names.clear();
+    m_lru.clear();
+    m_stats.size = 0U;
+}
+
+void evp_cache::set_budget(uint64_t budget) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    m_stats.budget = budget;
+    evict();
+}
+
+evp_cache::stats evp_cache::get_stats() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    stats result   = m_stats;
+    result.entries = (uint64_t)m_map.size();
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+void evp_cache::evict() {
+    while (m_stats.size > m_stats.budget && !m_lru.empty()) {
+        erase(std::prev(m_lru.end()));
+        m_stats.evictions++;
+    }
+}
+
+void evp_cache::erase(lru_t::iterator it) {
+    m_stats.size -= it->buffer->size();
+
+    for (const std::string& file : it->names) {
+        m_names.erase(name_key{ it->id.archive, file });
+    }
+
+    m_map.erase(it->id);
+    m_lru.erase(it);
+}
@@ -0,0 +1,231 @@
+#include "libevp/evp_hash_cache.hpp"
+#include "libevp/stream/stream_read.hpp"
+#include "libevp/stream/stream_write.hpp"
+#include "libevp/utilities/string.hpp"
+#include "libevp/defs.hpp"
+
+#include <cstring>
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <sys/stat.h>
+#endif
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+constexpr uint8_t HASH_CACHE_MAGIC[8] = {
+    0x45, 0x56, 0x50, 0x48, 0x41, 0x53, 0x48, 0x43
+};
+
+constexpr uint32_t HASH_CACHE_VERSION = 1;
+
+/*
+    Get file id that changes when file is replaced, 0 if not supported.
+*/
+static uint64_t read_inode(const FILE_PATH& file);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+bool evp_hash_cache::read_stamp(const FILE_PATH& file, stamp& stamp) {
+    std::error_code ec;
+
+    stamp.size = (uint64_t)std::filesystem::file_size(file, ec);
+    if (ec) return false;
+
+    auto time = std::filesystem::last_write_time(file, ec);
+    if (ec) return false;
+
+    stamp.mtime = (int64_t)time.time_since_epoch().count();
+    stamp.inode = read_inode(file);
+
+    return true;
+}
+
+evp_result evp_hash_cache::load(const FILE_PATH& file) {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    std::unordered_map<std::string, record> records;
+
+    try {
+        source_read stream(evp_source::from_mapped_file(file));
+        if (!stream.is_valid()) {
+            result.message = EVP_STR_FORMAT("Failed to map hash cache file.");
+            return result;
+        }
+
+        uint8_t magic[sizeof(HASH_CACHE_MAGIC)] = {};
+        stream.read(magic, sizeof(magic));
+
+        if (memcmp(magic, HASH_CACHE_MAGIC, sizeof(HASH_CACHE_MAGIC)) != 0 || stream.read<uint32_t>() != HASH_CACHE_VERSION) {
+            result.message = EVP_STR_FORMAT("Hash cache format not supported.");
+            return result;
+        }
+
+        uint32_t count = stream.read<uint32_t>();
+        records.reserve(count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            std::string key = stream.read(stream.read<uint32_t>());
+            record      rec;
+
+            rec.state.size  = stream.read<uint64_t>();
+            rec.state.mtime = stream.read<int64_t>();
+            rec.state.inode = stream.read<uint64_t>();
+            stream.read(rec.hash.data(), (uint32_t)rec.hash.size());
+
+            records[std::move(key)] = rec;
+        }
+    }
+    catch (const std::exception& e) {
+        result.message = EVP_STR_FORMAT("load() ex | {}", e.what());
+        return result;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_records = std::move(records);
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_result evp_hash_cache::save(const FILE_PATH& file) const {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    FILE_PATH tmp_path = file;
+    tmp_path += ".tmp";
+
+    try {
+        {
+            fstream_write stream(tmp_path, EVP_WRITE_BUFFER_SIZE);
+            if (!stream.is_valid()) {
+                result.message = EVP_STR_FORMAT("Failed to open hash cache file for writing.");
+                return result;
+            }
+
+            std::lock_guard<std::mutex> guard(m_mutex);
+
+            stream.write(HASH_CACHE_MAGIC, sizeof(HASH_CACHE_MAGIC));
+            stream.write(HASH_CACHE_VERSION);
+            stream.write((uint32_t)m_records.size());
+
+            for (const auto& [key, rec] : m_records) {
+                stream.write(std::string_view(key));
+                stream.write(rec.state.size);
+                stream.write(rec.state.mtime);
+                stream.write(rec.state.inode);
+                stream.write(rec.hash.data(), rec.hash.size());
+            }
+
+            stream.flush();
+        }
+
+        std::filesystem::rename(tmp_path, file);
+    }
+    catch (const std::exception& e) {
+        std::error_code ec;
+        std::filesystem::remove(tmp_path, ec);
+
+        result.message = EVP_STR_FORMAT("save() ex | {}", e.what());
+        return result;
+    }
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+bool evp_hash_cache::get(const FILE_PATH& file, const stamp& stamp, hash_t& hash) const {
+    std::string key = get_key(file);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto it = m_records.find(key);
+    if (it == m_records.end())
+        return false;
+
+    const record& rec = it->second;
+    if (rec.state.size != stamp.size || rec.state.mtime != stamp.mtime || rec.state.inode != stamp.inode)
+        return false;
+
+    hash = rec.hash;
+    return true;
+}
+
+void evp_hash_cache::set(const FILE_PATH& file, const stamp& stamp, const hash_t& hash) {
+    std::string key = get_key(file);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_records[std::move(key)] = { stamp, hash };
+}
+
+size_t evp_hash_cache::size() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_records.size();
+}
+
+void evp_hash_cache::clear() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_records.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+std::string evp_hash_cache::get_key(const FILE_PATH& file) {
+    std::error_code ec;
+
+    FILE_PATH path = std::filesystem::absolute(file, ec);
+    if (ec) path = file;
+
+    auto str = path.lexically_normal().generic_u8string();
+    return std::string(str.begin(), str.end());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+
+uint64_t read_inode(const FILE_PATH& file) {
+    HANDLE handle = CreateFileW(file.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return 0U;
+
+    BY_HANDLE_FILE_INFORMATION info = {};
+    BOOL ok = GetFileInformationByHandle(handle, &info);
+
+    CloseHandle(handle);
+
+    if (!ok)
+        return 0U;
+
+    return ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+}
+
+#elif defined(__linux__)
+
+uint64_t read_inode(const FILE_PATH& file) {
+    struct stat st = {};
+    if (stat(file.c_str(), &st) != 0)
+        return 0U;
+
+    return (uint64_t)st.st_ino;
+}
+
+#else
+
+uint64_t read_inode(const FILE_PATH& file) {
+    return 0U;
+}
+
+#endif
@@ -0,0 +1,584 @@
+#include "libevp/evp_index.hpp"
+#include "libevp/evp.hpp"
+#include "libevp/stream/stream_write.hpp"
+#include "libevp/misc/mapped_file.hpp"
+#include "libevp/utilities/string.hpp"
+
+#include <array>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+// archive header size, large enough for the 64-bit container
+// (magic + 4 * uint32_t + 2 * uint64_t)
+constexpr uint32_t ARCHIVE_HEADER_SIZE = 84;
+
+// smallest archive header (magic + 5 * uint32_t)
+constexpr uint32_t ARCHIVE_HEADER_MIN_SIZE = 76;
+
+constexpr uint8_t INDEX_MAGIC[8] = {
+    0x45, 0x56, 0x50, 0x49, 0x4E, 0x44, 0x45, 0x58
+};
+
+constexpr uint32_t INDEX_VERSION = 3;
+
+struct index_header {
+    uint8_t  magic[8]                            = {};
+    uint32_t version                             = 0U;
+    uint32_t header_size                         = 0U;
+    uint64_t archive_size                        = 0U;
+    int64_t  archive_mtime                       = 0;
+    uint8_t  archive_header[ARCHIVE_HEADER_SIZE] = {};
+    uint32_t file_count                          = 0U;
+    uint32_t bucket_count                        = 0U;
+    uint32_t records_offset                      = 0U;
+    uint32_t buckets_offset                      = 0U;
+    uint32_t names_offset                        = 0U;
+    uint32_t names_size                          = 0U;
+    uint32_t sorted_offset                       = 0U;
+};
+
+/*
+    Archive identity stored in the sidecar.
+*/
+struct archive_stamp {
+    uint64_t                                  size   = 0U;
+    int64_t                                   mtime  = 0;
+    std::array<uint8_t, ARCHIVE_HEADER_SIZE> header = {};
+};
+
+/*
+    Read archive size, mtime and header.
+*/
+static bool read_archive_stamp(const FILE_PATH& archive, archive_stamp& stamp);
+
+/*
+    FNV-1a hash, stable across platforms and runs.
+*/
+static uint32_t hash_name(const char* name, uint32_t size);
+
+/*
+    Match name against glob pattern.
+*/
+static bool glob_match(std::string_view pattern, std::string_view name);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+struct evp_index::record {
+    uint32_t name_offset          = 0U;
+    uint32_t name_size            = 0U;
+    uint64_t data_offset          = 0U;
+    uint64_t data_size            = 0U;
+    uint64_t data_compressed_size = 0U;
+    uint32_t flags                = 0U;
+    uint32_t _reserved            = 0U;
+    uint8_t  hash[16]             = {};
+};
+
+evp_index::evp_index() {}
+
+evp_index::~evp_index() {
+    close();
+}
+
+FILE_PATH evp_index::get_default_path(const FILE_PATH& archive) {
+    FILE_PATH path = archive;
+    path += ".idx";
+
+    return path;
+}
+
+evp_result evp_index::build(const FILE_PATH& archive, const FILE_PATH& index) {
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    FILE_PATH index_path = index.empty() ? get_default_path(archive) : index;
+
+    std::vector<evp_fd> files = {};
+
+    evp evp;
+    res = evp.get_archive_fds(archive, files);
+    if (!res) {
+        result.message = res.message;
+        return result;
+    }
+
+    archive_stamp stamp;
+    if (!read_archive_stamp(archive, stamp)) {
+        result.message = EVP_STR_FORMAT("Failed to read archive header.");
+        return result;
+    }
+
+    index_header header;
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    memcpy(header.archive_header, stamp.header.data(), ARCHIVE_HEADER_SIZE);
+
+    header.version       = INDEX_VERSION;
+    header.header_size   = (uint32_t)sizeof(index_header);
+    header.archive_size  = stamp.size;
+    header.archive_mtime = stamp.mtime;
+    header.file_count    = (uint32_t)files.size();
+
+    // power of two with load factor <= 0.5
+    header.bucket_count = 1U;
+    while (header.bucket_count < header.file_count * 2U)
+        header.bucket_count <<= 1;
+
+    std::vector<record>   records(files.size());
+    std::vector<uint32_t> buckets(header.bucket_count, 0U);
+    std::string           names = "";
+
+    for (uint32_t i = 0; i < header.file_count; i++) {
+        evp_fd& fd  = files[i];
+        record& rec = records[i];
+
+        rec.name_offset          = (uint32_t)names.size();
+        rec.name_size            = (uint32_t)fd.file.size();
+        rec.data_offset          = fd.data_offset;
+        rec.data_size            = fd.data_size;
+        rec.data_compressed_size = fd.data_compressed_size;
+        rec.flags                = fd.flags;
+        memcpy(rec.hash, fd.hash.data(), sizeof(rec.hash));
+
+        names += fd.file;
+
+        // linear probing, slots hold position + 1
+        uint32_t mask = header.bucket_count - 1;
+        uint32_t slot = hash_name(fd.file.data(), rec.name_size) & mask;
+
+        while (buckets[slot] != 0U) {
+            const record& other = records[buckets[slot] - 1];
+
+            // keep first occurrence of duplicate names
+            if (other.name_size == rec.name_size && memcmp(names.data() + other.name_offset, fd.file.data(), rec.name_size) == 0)
+                break;
+
+            slot = (slot + 1) & mask;
+        }
+
+        if (buckets[slot] == 0U)
+            buckets[slot] = i + 1;
+    }
+
+    std::vector<uint32_t> sorted(records.size());
+    for (uint32_t i = 0; i < (uint32_t)sorted.size(); i++) {
+        sorted[i] = i;
+    }
+
+    std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) {
+        std::string_view name_a(names.data() + records[a].name_offset, records[a].name_size);
+        std::string_view name_b(names.data() + records[b].name_offset, records[b].name_size);
+
+        return name_a < name_b;
+    });
+
+    header.records_offset = header.header_size;
+    header.buckets_offset = header.records_offset + (uint32_t)(records.size() * sizeof(record));
+    header.sorted_offset  = header.buckets_offset + (uint32_t)(buckets.size() * sizeof(uint32_t));
+    header.names_offset   = header.sorted_offset + (uint32_t)(sorted.size() * sizeof(uint32_t));
+    header.names_size     = (uint32_t)names.size();
+
+    FILE_PATH tmp_path = index_path;
+    tmp_path += ".tmp";
+
+    try {
+        {
+            fstream_write stream(tmp_path);
+            if (!stream.is_valid()) {
+                result.message = EVP_STR_FORMAT("Failed to open index file for writing.");
+                return result;
+            }
+
+            stream.write((uint8_t*)&header, (uint32_t)sizeof(header));
+            stream.write((uint8_t*)records.data(), (uint32_t)(records.size() * sizeof(record)));
+            stream.write((uint8_t*)buckets.data(), (uint32_t)(buckets.size() * sizeof(uint32_t)));
+            stream.write((uint8_t*)sorted.data(), (uint32_t)(sorted.size() * sizeof(uint32_t)));
+            stream.write((uint8_t*)names.data(), (uint32_t)names.size());
+        }
+
+        std::filesystem::rename(tmp_path, index_path);
+    }
+    catch (const std::exception& e) {
+        std::error_code ec;
+        std::filesystem::remove(tmp_path, ec);
+
+        result.message = EVP_STR_FORMAT("build() ex | {}", e.what());
+        return result;
+    }
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_result evp_index::load(const FILE_PATH& archive, const FILE_PATH& index) {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    close();
+
+    FILE_PATH index_path = index.empty() ? get_default_path(archive) : index;
+
+    auto file = std::make_unique<mapped_file>(index_path);
+    if (!file->is_valid()) {
+        result.message = EVP_STR_FORMAT("Failed to map index file.");
+        return result;
+    }
+
+    if (file->size() < sizeof(index_header)) {
+        result.message = EVP_STR_FORMAT("Index file too small.");
+        return result;
+    }
+
+    index_header header;
+    memcpy(&header, file->data(), sizeof(index_header));
+
+    if (memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.version != INDEX_VERSION ||
+        header.header_size != sizeof(index_header))
+    {
+        result.message = EVP_STR_FORMAT("Index format not supported.");
+        return result;
+    }
+
+    archive_stamp stamp;
+    if (!read_archive_stamp(archive, stamp)) {
+        result.message = EVP_STR_FORMAT("Failed to read archive header.");
+        return result;
+    }
+
+    if (header.archive_size != stamp.size || header.archive_mtime != stamp.mtime ||
+        memcmp(header.archive_header, stamp.header.data(), ARCHIVE_HEADER_SIZE) != 0)
+    {
+        result.message = EVP_STR_FORMAT("Index is stale.");
+        return result;
+    }
+
+    uint64_t records_end = (uint64_t)header.records_offset + (uint64_t)header.file_count * sizeof(record);
+    uint64_t buckets_end = (uint64_t)header.buckets_offset + (uint64_t)header.bucket_count * sizeof(uint32_t);
+    uint64_t sorted_end  = (uint64_t)header.sorted_offset + (uint64_t)header.file_count * sizeof(uint32_t);
+    uint64_t names_end   = (uint64_t)header.names_offset + (uint64_t)header.names_size;
+
+    if (records_end > file->size() || buckets_end > file->size() || sorted_end > file->size() || names_end > file->size() ||
+        header.bucket_count == 0U || (header.bucket_count & (header.bucket_count - 1)) != 0U)
+    {
+        result.message = EVP_STR_FORMAT("Index file corrupted.");
+        return result;
+    }
+
+    const record*   records = reinterpret_cast<const record*>(file->data() + header.records_offset);
+    const uint32_t* buckets = reinterpret_cast<const uint32_t*>(file->data() + header.buckets_offset);
+    const uint32_t* sorted  = reinterpret_cast<const uint32_t*>(file->data() + header.sorted_offset);
+    const char*     names   = reinterpret_cast<const char*>(file->data() + header.names_offset);
+
+    // values read from the sidecar are used unchecked later
+    bool valid = true;
+
+    for (uint32_t i = 0; valid && i < header.file_count; i++) {
+        const record& rec = records[i];
+
+        valid = (uint64_t)rec.name_offset + rec.name_size <= header.names_size && sorted[i] < header.file_count;
+    }
+
+    auto get_sorted_name = [&](uint32_t i) {
+        const record& rec = records[sorted[i]];
+        return std::string_view(names + rec.name_offset, rec.name_size);
+    };
+
+    // queries binary search the sorted order, a permutation is ordered
+    // by name and unique if each position holds a different record
+    std::vector<bool> seen(valid ? header.file_count : 0U, false);
+
+    for (uint32_t i = 0; valid && i < header.file_count; i++) {
+        valid = !seen[sorted[i]] && (i == 0 || get_sorted_name(i - 1) <= get_sorted_name(i));
+        seen[sorted[i]] = true;
+    }
+
+    // slots hold position + 1
+    for (uint32_t i = 0; valid && i < header.bucket_count; i++) {
+        valid = buckets[i] <= header.file_count;
+    }
+
+    if (!valid) {
+        result.message = EVP_STR_FORMAT("Index file corrupted.");
+        return result;
+    }
+
+    m_records      = records;
+    m_buckets      = buckets;
+    m_sorted       = sorted;
+    m_names        = names;
+    m_count        = header.file_count;
+    m_bucket_count = header.bucket_count;
+    m_file         = std::move(file);
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_result evp_index::open(const FILE_PATH& archive, const FILE_PATH& index) {
+    auto result = load(archive, index);
+    if (result)
+        return result;
+
+    result = build(archive, index);
+    if (!result)
+        return result;
+
+    return load(archive, index);
+}
+
+void evp_index::close() {
+    m_file         = nullptr;
+    m_records      = nullptr;
+    m_buckets      = nullptr;
+    m_sorted       = nullptr;
+    m_names        = nullptr;
+    m_count        = 0U;
+    m_bucket_count = 0U;
+}
+
+size_t evp_index::size() const {
+    return m_count;
+}
+
+void evp_index::get_fd(size_t index, evp_fd& fd) const {
+    if (index >= m_count)
+        throw std::out_of_range("Index out of bounds.");
+
+    const record& rec = m_records[index];
+
+    fd.file.assign(m_names + rec.name_offset, rec.name_size);
+    fd.data_offset          = rec.data_offset;
+    fd.data_size            = rec.data_size;
+    fd.data_compressed_size = rec.data_compressed_size;
+    fd.flags                = rec.flags;
+    memcpy(fd.hash.data(), rec.hash, fd.hash.size());
+}
+
+evp_result evp_index::find(const FILE_PATH& file, evp_fd& fd) const {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    const record* rec = find_record(to_fd_name(file));
+    if (!rec) {
+        result.message = EVP_STR_FORMAT("File not found.");
+        return result;
+    }
+
+    get_fd((size_t)(rec - m_records), fd);
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_fd_view evp_index::get_view(size_t index) const {
+    if (index >= m_count)
+        throw std::out_of_range("Index out of bounds.");
+
+    const record& rec = m_records[index];
+
+    evp_fd_view fd;
+    fd.file                 = get_name((uint32_t)index);
+    fd.data_offset          = rec.data_offset;
+    fd.data_size            = rec.data_size;
+    fd.data_compressed_size = rec.data_compressed_size;
+    fd.flags                = rec.flags;
+    fd.hash                 = rec.hash;
+
+    return fd;
+}
+
+std::vector<evp_fd_view> evp_index::find_prefix(const FILE_PATH& prefix) const {
+    std::vector<evp_fd_view> files = {};
+
+    auto [first, last] = get_prefix_range(to_fd_name(prefix));
+
+    files.reserve(last - first);
+    for (uint32_t i = first; i < last; i++) {
+        files.push_back(get_view(m_sorted[i]));
+    }
+
+    return files;
+}
+
+void evp_index::list_dir(const FILE_PATH& dir, std::vector<evp_fd_view>& files,
+    std::vector<std::string_view>* dirs) const
+{
+    std::string prefix = to_fd_name(dir);
+    if (!prefix.empty() && prefix.back() != '/')
+        prefix += '/';
+
+    auto [first, last] = get_prefix_range(prefix);
+
+    uint32_t i = first;
+    while (i < last) {
+        std::string_view name  = get_name(m_sorted[i]);
+        size_t           slash = name.find('/', prefix.size());
+
+        if (slash == std::string_view::npos) {
+            files.push_back(get_view(m_sorted[i]));
+            i++;
+            continue;
+        }
+
+        std::string_view sub_dir = name.substr(0, slash + 1);
+
+        if (dirs)
+            dirs->push_back(sub_dir.substr(prefix.size(), slash - prefix.size()));
+
+        // skip the whole subdirectory
+        i = get_prefix_range(sub_dir, i).second;
+    }
+}
+
+std::vector<evp_fd_view> evp_index::glob(const FILE_PATH& pattern) const {
+    std::vector<evp_fd_view> files = {};
+
+    std::string glob_pattern = to_fd_name(pattern);
+    std::string literal      = glob_pattern.substr(0, glob_pattern.find_first_of("*?"));
+
+    auto [first, last] = get_prefix_range(literal);
+
+    for (uint32_t i = first; i < last; i++) {
+        std::string_view name = get_name(m_sorted[i]);
+
+        if (glob_match(std::string_view(glob_pattern).substr(literal.size()), name.substr(literal.size())))
+            files.push_back(get_view(m_sorted[i]));
+    }
+
+    return files;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+std::string_view evp_index::get_name(uint32_t index) const {
+    const record& rec = m_records[index];
+    return std::string_view(m_names + rec.name_offset, rec.name_size);
+}
+
+std::pair<uint32_t, uint32_t> evp_index::get_prefix_range(std::string_view prefix, uint32_t first) const {
+    if (!m_sorted)
+        return { 0U, 0U };
+
+    const uint32_t* begin = m_sorted + first;
+    const uint32_t* end   = m_sorted + m_count;
+
+    const uint32_t* lower = std::partition_point(begin, end, [&](uint32_t index) {
+        return get_name(index) < prefix;
+    });
+
+    const uint32_t* upper = std::partition_point(lower, end, [&](uint32_t index) {
+        return get_name(index).substr(0, prefix.size()) == prefix;
+    });
+
+    return { (uint32_t)(lower - m_sorted), (uint32_t)(upper - m_sorted) };
+}
+
+const evp_index::record* evp_index::find_record(const std::string& file) const {
+    if (!m_buckets) return nullptr;
+
+    uint32_t mask = m_bucket_count - 1;
+    uint32_t slot = hash_name(file.data(), (uint32_t)file.size()) & mask;
+
+    for (uint32_t i = 0; i < m_bucket_count; i++) {
+        uint32_t value = m_buckets[slot];
+        if (value == 0U || value > m_count)
+            return nullptr;
+
+        const record& rec = m_records[value - 1];
+
+        if (rec.name_size == file.size() && memcmp(m_names + rec.name_offset, file.data(), rec.name_size) == 0)
+            return &rec;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+bool read_archive_stamp(const FILE_PATH& archive, archive_stamp& stamp) {
+    std::error_code ec;
+
+    stamp.size = (uint64_t)std::filesystem::file_size(archive, ec);
+    if (ec) return false;
+
+    auto time = std::filesystem::last_write_time(archive, ec);
+    if (ec) return false;
+
+    stamp.mtime = (int64_t)time.time_since_epoch().count();
+
+    std::ifstream stream(archive, std::ios::binary);
+    if (!stream.is_open())
+        return false;
+
+    // narrow archives can be shorter than the stamp, rest stays zeroed
+    stream.read((char*)stamp.header.data(), ARCHIVE_HEADER_SIZE);
+    return stream.gcount() >= ARCHIVE_HEADER_MIN_SIZE;
+}
+
+uint32_t hash_name(const char* name, uint32_t size) {
+    uint32_t hash = 0x811C9DC5;
+
+    for (uint32_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 0x01000193;
+    }
+
+    return hash;
+}
+
+bool glob_match(std::string_view pattern, std::string_view name) {
+    size_t p = 0U;
+    size_t n = 0U;
+
+    while (p < pattern.size()) {
+        char c = pattern[p];
+
+        if (c == '*') {
+            bool any = p + 1 < pattern.size() && pattern[p + 1] == '*';
+            p += any ? 2 : 1;
+
+            if (p == pattern.size())
+                return any || name.find('/', n) == std::string_view::npos;
+
+            // "**/" also matches no directories
+            if (any && pattern[p] == '/' && glob_match(pattern.substr(p + 1), name.substr(n)))
+                return true;
+
+            for (size_t i = n; i <= name.size(); i++) {
+                if (glob_match(pattern.substr(p), name.substr(i)))
+                    return true;
+
+                if (!any && i < name.size() && name[i] == '/')
+                    break;
+            }
+
+            return false;
+        }
+
+        if (n >= name.size())
+            return false;
+
+        if (c == '?') {
+            if (name[n] == '/')
+                return false;
+        }
+        else if (c != name[n]) {
+            return false;
+        }
+
+        p++;
+        n++;
+    }
+
+    return n == name.size();
+}
@@ -0,0 +1,148 @@
+#include "libevp/evp_sink.hpp"
+#include "libevp/stream/stream_write.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+/*
+    Sink over an unbuffered file stream, callers buffer writes.
+*/
+class file_sink : public evp_sink {
+public:
+    file_sink(const FILE_PATH& file)
+        : m_stream(file) {}
+
+public:
+    bool is_valid() const override final {
+        return m_stream.is_valid();
+    }
+
+    uint64_t pos() const override final {
+        return m_stream.pos();
+    }
+
+    void write(const uint8_t* src, size_t size) override final {
+        m_stream.write(src, size);
+    }
+
+    void seek(uint64_t offset) override final {
+        m_stream.seek(offset, std::ios::beg);
+    }
+
+    bool preallocate(uint64_t size) override final {
+        return m_stream.preallocate(size);
+    }
+
+    bool copy_from(const FILE_PATH& file, uint64_t offset, uint64_t size) override final {
+        return m_stream.copy_from(file, offset, size);
+    }
+
+    void flush() override final {
+        m_stream.flush();
+    }
+
+private:
+    fstream_write m_stream;
+};
+
+/*
+    Sink over caller owned buffer.
+*/
+class memory_sink : public evp_sink {
+public:
+    memory_sink(std::vector<uint8_t>& buffer)
+        : m_buffer(buffer)
+    {
+        m_buffer.clear();
+    }
+
+public:
+    bool is_valid() const override final {
+        return true;
+    }
+
+    uint64_t pos() const override final {
+        return m_pos;
+    }
+
+    void write(const uint8_t* src, size_t size) override final {
+        if (m_pos + size > m_buffer.size())
+            m_buffer.resize(m_pos + size);
+
+        memcpy(m_buffer.data() + m_pos, src, size);
+        m_pos += size;
+    }
+
+    void seek(uint64_t offset) override final {
+        if (offset > m_buffer.size())
+            throw std::out_of_range("Tried to seek outside bounds.");
+
+        m_pos = (size_t)offset;
+    }
+
+    bool preallocate(uint64_t size) override final {
+        m_buffer.reserve((size_t)size);
+        return true;
+    }
+
+private:
+    std::vector<uint8_t>& m_buffer;
+    size_t                m_pos = 0U;
+};
+
+/*
+    Sequential sink writing through user callback.
+*/
+class callback_sink : public evp_sink {
+public:
+    callback_sink(write_cb_t cb)
+        : m_cb(std::move(cb)) {}
+
+public:
+    bool is_valid() const override final {
+        return (bool)m_cb;
+    }
+
+    uint64_t pos() const override final {
+        return m_pos;
+    }
+
+    void write(const uint8_t* src, size_t size) override final {
+        if (!m_cb(src, size))
+            throw std::runtime_error("Failed to write requested size.");
+
+        m_pos += size;
+    }
+
+    void seek(uint64_t offset) override final {
+        throw std::logic_error("Sink isn't seekable.");
+    }
+
+    bool is_seekable() const override final {
+        return false;
+    }
+
+private:
+    write_cb_t m_cb;
+    uint64_t   m_pos = 0U;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+evp_sink::ptr_t evp_sink::from_file(const FILE_PATH& file) {
+    return std::make_shared<file_sink>(file);
+}
+
+evp_sink::ptr_t evp_sink::from_memory(std::vector<uint8_t>& buffer) {
+    return std::make_shared<memory_sink>(buffer);
+}
+
+evp_sink::ptr_t evp_sink::from_callback(write_cb_t cb) {
+    return std::make_shared<callback_sink>(std::move(cb));
+}
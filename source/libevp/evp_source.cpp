@@ -0,0 +1,201 @@
+#include "libevp/evp_source.hpp"
+#include "libevp/misc/mapped_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+/*
+    Source over a file stream, seeks only when reads aren't sequential.
+    File is opened on first read so many sources can be created up front.
+    Can cover only a part of the file.
+*/
+class file_source : public evp_source {
+public:
+    file_source(const FILE_PATH& file)
+        : m_path(file)
+    {
+        std::error_code ec;
+
+        m_size = (uint64_t)std::filesystem::file_size(file, ec);
+        if (ec) return;
+
+        m_valid = true;
+    }
+
+    file_source(const FILE_PATH& file, uint64_t offset, uint64_t size)
+        : m_path(file), m_base(offset)
+    {
+        std::error_code ec;
+
+        uint64_t file_size = (uint64_t)std::filesystem::file_size(file, ec);
+        if (ec || offset + size > file_size) return;
+
+        m_size  = size;
+        m_valid = true;
+    }
+
+public:
+    uint64_t size() const override final {
+        return m_size;
+    }
+
+    bool is_valid() const override final {
+        return m_valid;
+    }
+
+    void read(uint64_t offset, uint8_t* dst, size_t size) override final {
+        if (offset + size > m_size)
+            throw std::out_of_range("Tried to read outside file bounds.");
+
+        if (!m_stream.is_open()) {
+            m_stream.open(m_path, std::ios::binary);
+
+            if (!m_stream.is_open()) {
+                m_valid = false;
+                throw std::runtime_error("Failed to open file for reading.");
+            }
+
+            m_pos = 0U;
+        }
+
+        offset += m_base;
+
+        if (offset != m_pos) {
+            m_stream.clear();
+
+            if (!m_stream.seekg((std::streamoff)offset, std::ios::beg))
+                throw std::out_of_range("Tried to seek outside file bounds.");
+        }
+
+        // force a seek on next read if this one fails
+        m_pos = UINT64_MAX;
+
+        if (!m_stream.read((char*)dst, (std::streamsize)size))
+            throw std::runtime_error("Failed to read requested size.");
+
+        m_pos = offset + size;
+    }
+
+    bool get_file_extent(FILE_PATH& file, uint64_t& offset) const override final {
+        file   = m_path;
+        offset = m_base;
+
+        return m_valid;
+    }
+
+private:
+    FILE_PATH     m_path;
+    std::ifstream m_stream;
+    uint64_t      m_base  = 0U;
+    uint64_t      m_size  = 0U;
+    uint64_t      m_pos   = 0U;
+    bool          m_valid = false;
+};
+
+/*
+    Source over caller owned memory.
+*/
+class memory_source : public evp_source {
+public:
+    memory_source(const uint8_t* data, size_t size)
+        : m_data(data), m_size(size) {}
+
+public:
+    uint64_t size() const override {
+        return m_size;
+    }
+
+    bool is_valid() const override {
+        return m_data != nullptr;
+    }
+
+    void read(uint64_t offset, uint8_t* dst, size_t size) override final {
+        if (offset + size > m_size)
+            throw std::out_of_range("Tried to read outside bounds.");
+
+        memcpy(dst, m_data + offset, size);
+    }
+
+    const uint8_t* data() const override final {
+        return m_data;
+    }
+
+protected:
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0U;
+};
+
+/*
+    Memory source that owns the mapping.
+*/
+class mapped_source : public memory_source {
+public:
+    mapped_source(const FILE_PATH& file)
+        : memory_source(nullptr, 0U), m_file(file)
+    {
+        m_data = m_file.data();
+        m_size = m_file.size();
+    }
+
+private:
+    mapped_file m_file;
+};
+
+/*
+    Source reading through user callback.
+*/
+class callback_source : public evp_source {
+public:
+    callback_source(uint64_t size, read_cb_t cb)
+        : m_size(size), m_cb(std::move(cb)) {}
+
+public:
+    uint64_t size() const override final {
+        return m_size;
+    }
+
+    bool is_valid() const override final {
+        return (bool)m_cb;
+    }
+
+    void read(uint64_t offset, uint8_t* dst, size_t size) override final {
+        if (offset + size > m_size)
+            throw std::out_of_range("Tried to read outside bounds.");
+
+        if (!m_cb(offset, dst, size))
+            throw std::runtime_error("Failed to read requested size.");
+    }
+
+private:
+    uint64_t  m_size = 0U;
+    read_cb_t m_cb;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+evp_source::ptr_t evp_source::from_file(const FILE_PATH& file) {
+    return std::make_shared<file_source>(file);
+}
+
+evp_source::ptr_t evp_source::from_file_range(const FILE_PATH& file, uint64_t offset, uint64_t size) {
+    return std::make_shared<file_source>(file, offset, size);
+}
+
+evp_source::ptr_t evp_source::from_mapped_file(const FILE_PATH& file) {
+    return std::make_shared<mapped_source>(file);
+}
+
+evp_source::ptr_t evp_source::from_memory(const uint8_t* data, size_t size) {
+    return std::make_shared<memory_source>(data, size);
+}
+
+evp_source::ptr_t evp_source::from_callback(uint64_t size, read_cb_t cb) {
+    return std::make_shared<callback_source>(size, std::move(cb));
+}
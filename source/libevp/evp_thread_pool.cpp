@@ -0,0 +1,222 @@
+#include "libevp/evp_thread_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+// default max concurrent I/O heavy tasks
+constexpr uint32_t EVP_DEFAULT_IO_LIMIT = 4;
+
+/*
+    Process wide counting limit for I/O heavy tasks.
+*/
+class io_limiter {
+public:
+    using wake_t = std::function<void()>;
+
+public:
+    bool try_acquire() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        if (m_limit != 0U && m_active >= m_limit)
+            return false;
+
+        m_active++;
+        return true;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_active--;
+        }
+
+        wake_pools();
+    }
+
+    void set_limit(uint32_t limit) {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_limit = limit;
+        }
+
+        wake_pools();
+    }
+
+    uint32_t get_limit() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_limit;
+    }
+
+    void add_pool(const void* pool, wake_t wake) {
+        std::lock_guard<std::mutex> guard(m_pools_mutex);
+        m_pools.emplace_back(pool, std::move(wake));
+    }
+
+    void remove_pool(const void* pool) {
+        std::lock_guard<std::mutex> guard(m_pools_mutex);
+        std::erase_if(m_pools, [&](const auto& entry) { return entry.first == pool; });
+    }
+
+private:
+    std::mutex                                  m_mutex;
+    uint32_t                                    m_limit  = EVP_DEFAULT_IO_LIMIT;
+    uint32_t                                    m_active = 0U;
+    std::mutex                                  m_pools_mutex;
+    std::vector<std::pair<const void*, wake_t>> m_pools;
+
+private:
+    // freed slot may be taken by a queued task of any pool
+    void wake_pools() {
+        std::lock_guard<std::mutex> guard(m_pools_mutex);
+
+        for (auto& [pool, wake] : m_pools) {
+            wake();
+        }
+    }
+};
+
+static io_limiter& get_io_limiter();
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+evp_thread_pool::evp_thread_pool(uint32_t thread_count) {
+    if (thread_count == 0U)
+        thread_count = std::max(1U, std::thread::hardware_concurrency());
+
+    // taking the lock orders the wake after a worker's failed slot check
+    get_io_limiter().add_pool(this, [this] {
+        { std::lock_guard<std::mutex> guard(m_mutex); }
+        m_cv.notify_all();
+    });
+
+    for (uint32_t i = 0; i < thread_count; i++) {
+        m_threads.emplace_back(&evp_thread_pool::worker, this);
+    }
+}
+
+evp_thread_pool::~evp_thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_stop = true;
+    }
+
+    m_cv.notify_all();
+
+    for (auto& thread : m_threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+
+    get_io_limiter().remove_pool(this);
+}
+
+std::shared_ptr<evp_thread_pool> evp_thread_pool::get_global() {
+    // limiter must outlive the global pool
+    get_io_limiter();
+
+    static std::shared_ptr<evp_thread_pool> pool = std::make_shared<evp_thread_pool>(0U);
+    return pool;
+}
+
+void evp_thread_pool::set_io_limit(uint32_t limit) {
+    get_io_limiter().set_limit(limit);
+}
+
+uint32_t evp_thread_pool::get_io_limit() {
+    return get_io_limiter().get_limit();
+}
+
+void evp_thread_pool::post(task_t task) {
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+
+    m_cv.notify_one();
+}
+
+void evp_thread_pool::post_io(task_t task) {
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_io_tasks.push_back(std::move(task));
+    }
+
+    m_cv.notify_one();
+}
+
+void evp_thread_pool::wait_idle() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [&] { return m_tasks.empty() && m_io_tasks.empty() && m_running == 0U; });
+}
+
+size_t evp_thread_pool::get_thread_count() const {
+    return m_threads.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+void evp_thread_pool::worker() {
+    io_limiter& limiter = get_io_limiter();
+
+    while (true) {
+        task_t task;
+        bool   io = false;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while (true) {
+                if (!m_tasks.empty()) {
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                    break;
+                }
+
+                // I/O tasks are only taken once they hold a slot
+                if (!m_io_tasks.empty() && limiter.try_acquire()) {
+                    task = std::move(m_io_tasks.front());
+                    m_io_tasks.pop_front();
+                    io = true;
+                    break;
+                }
+
+                if (m_stop && m_io_tasks.empty())
+                    return;
+
+                m_cv.wait(lock);
+            }
+
+            m_running++;
+        }
+
+        try {
+            task();
+        }
+        catch (...) {}
+
+        if (io)
+            limiter.release();
+
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_running--;
+        }
+
+        m_idle_cv.notify_all();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+io_limiter& get_io_limiter() {
+    static io_limiter limiter;
+    return limiter;
+}
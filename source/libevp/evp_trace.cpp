@@ -0,0 +1,167 @@
+#include "libevp/evp_trace.hpp"
+#include "libevp/stream/stream_write.hpp"
+#include "libevp/utilities/string.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <unordered_set>
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+/*
+    Escape string for use inside a JSON string.
+*/
+static std::string json_escape(const std::string& str);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+evp_trace::evp_trace()
+    : m_origin(clock_t::now()) {}
+
+void evp_trace::add_span(span span) {
+    std::thread::id id = std::this_thread::get_id();
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto it = m_threads.find(id);
+    if (it == m_threads.end())
+        it = m_threads.emplace(id, (uint32_t)m_threads.size() + 1).first;
+
+    m_events.push_back({ std::move(span), it->second });
+}
+
+void evp_trace::clear() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_events.clear();
+    m_threads.clear();
+}
+
+size_t evp_trace::size() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_events.size();
+}
+
+std::vector<evp_access_record> evp_trace::get_access_records() const {
+    std::vector<const event*> entries;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    for (const event& event : m_events) {
+        if (strcmp(event.span.name, "entry") == 0 && !event.span.file.empty())
+            entries.push_back(&event);
+    }
+
+    // events are recorded when spans end
+    std::stable_sort(entries.begin(), entries.end(), [](const event* a, const event* b) {
+        return a->span.start < b->span.start;
+    });
+
+    std::vector<evp_access_record>  records;
+    std::unordered_set<std::string> seen;
+
+    for (const event* event : entries) {
+        if (!seen.insert(event->span.file).second)
+            continue;
+
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(event->span.start - m_origin).count();
+        records.push_back({ event->span.file, (uint64_t)time });
+    }
+
+    return records;
+}
+
+std::string evp_trace::to_json() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    std::string json = "{\"traceEvents\":[";
+    json.reserve(json.size() + m_events.size() * 128);
+
+    for (size_t i = 0; i < m_events.size(); i++) {
+        const event& event = m_events[i];
+
+        auto ts  = std::chrono::duration_cast<std::chrono::nanoseconds>(event.span.start - m_origin).count();
+        auto dur = std::chrono::duration_cast<std::chrono::nanoseconds>(event.span.end - event.span.start).count();
+
+        if (i != 0)
+            json += ",";
+
+        json += EVP_STR_FORMAT("\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}",
+            event.span.name, event.span.category, ts / 1000.0, dur / 1000.0, event.tid);
+
+        if (event.span.data_offset != UINT64_MAX || !event.span.file.empty()) {
+            json += ",\"args\":{";
+
+            if (event.span.data_offset != UINT64_MAX)
+                json += EVP_STR_FORMAT("\"data_offset\":{}", event.span.data_offset);
+
+            if (!event.span.file.empty()) {
+                if (event.span.data_offset != UINT64_MAX)
+                    json += ",";
+
+                json += EVP_STR_FORMAT("\"file\":\"{}\"", json_escape(event.span.file));
+            }
+
+            json += "}";
+        }
+
+        json += "}";
+    }
+
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return json;
+}
+
+evp_result evp_trace::save(const FILE_PATH& output) const {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    std::string json = to_json();
+
+    try {
+        fstream_write stream(output);
+        if (!stream.is_valid()) {
+            result.message = EVP_STR_FORMAT("Failed to open trace file for writing.");
+            return result;
+        }
+
+        stream.write((uint8_t*)json.data(), (uint32_t)json.size());
+    }
+    catch (const std::exception& e) {
+        result.message = EVP_STR_FORMAT("save() ex | {}", e.what());
+        return result;
+    }
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+std::string json_escape(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+
+    for (char c : str) {
+        switch (c) {
+            case '"':  result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n";  break;
+            case '\r': result += "\\r";  break;
+            case '\t': result += "\\t";  break;
+            default:
+                if ((uint8_t)c < 0x20)
+                    result += EVP_STR_FORMAT("\\u{:04x}", (uint32_t)(uint8_t)c);
+                else
+                    result += c;
+
+                break;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,186 @@
+#include "libevp/evp_vfs.hpp"
+#include "libevp/utilities/string.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+using namespace libevp;
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+/*
+    Convert archive path to comparable form.
+*/
+static FILE_PATH to_archive_path(const FILE_PATH& archive);
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+evp_result evp_vfs::mount(const FILE_PATH& archive, int32_t priority) {
+    evp_result result, res;
+    result.status = evp_result::status::failure;
+
+    auto mount      = std::make_unique<mount_t>();
+    mount->archive  = to_archive_path(archive);
+    mount->priority = priority;
+
+    res = m_evp.get_archive_fds(mount->archive, mount->files);
+    if (!res) {
+        result.message = EVP_STR_FORMAT("Failed to read archive. | {}", res.message);
+        return result;
+    }
+
+    mount->index.reserve(mount->files.size());
+    for (uint32_t i = 0; i < (uint32_t)mount->files.size(); i++) {
+        mount->index.emplace(to_fd_name(mount->files[i].file), i);
+    }
+
+    std::unique_lock<std::shared_mutex> guard(m_mutex);
+
+    for (auto& mounted : m_mounts) {
+        if (mounted->archive != mount->archive) continue;
+
+        result.message = EVP_STR_FORMAT("Already mounted.");
+        return result;
+    }
+
+    mount->order = m_order++;
+
+    // merge only the new archive files, existing refs stay untouched unless shadowed
+    for (auto& [key, index] : mount->index) {
+        auto it = m_index.find(key);
+
+        if (it == m_index.end())
+            m_index.emplace(key, ref_t{ mount.get(), index });
+        else if (mount->shadows(*it->second.mount))
+            it->second = ref_t{ mount.get(), index };
+    }
+
+    m_mounts.push_back(std::move(mount));
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_result evp_vfs::unmount(const FILE_PATH& archive) {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    FILE_PATH path = to_archive_path(archive);
+
+    std::unique_lock<std::shared_mutex> guard(m_mutex);
+
+    auto mount_it = std::find_if(m_mounts.begin(), m_mounts.end(), [&](const std::unique_ptr<mount_t>& mount) {
+        return mount->archive == path;
+    });
+
+    if (mount_it == m_mounts.end()) {
+        result.message = EVP_STR_FORMAT("Not mounted.");
+        return result;
+    }
+
+    std::unique_ptr<mount_t> mount = std::move(*mount_it);
+    m_mounts.erase(mount_it);
+
+    // re-resolve only files owned by the removed archive
+    for (auto& [key, index] : mount->index) {
+        auto it = m_index.find(key);
+        if (it == m_index.end() || it->second.mount != mount.get()) continue;
+
+        ref_t ref = {};
+
+        for (auto& other : m_mounts) {
+            auto other_it = other->index.find(key);
+            if (other_it == other->index.end()) continue;
+
+            if (!ref.mount || other->shadows(*ref.mount))
+                ref = ref_t{ other.get(), other_it->second };
+        }
+
+        if (ref.mount)
+            it->second = ref;
+        else
+            m_index.erase(it);
+    }
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+std::vector<FILE_PATH> evp_vfs::get_mounts() const {
+    std::shared_lock<std::shared_mutex> guard(m_mutex);
+
+    std::vector<const mount_t*> mounts = {};
+    for (auto& mount : m_mounts) {
+        mounts.push_back(mount.get());
+    }
+
+    std::sort(mounts.begin(), mounts.end(), [](const mount_t* a, const mount_t* b) {
+        return a->shadows(*b);
+    });
+
+    std::vector<FILE_PATH> archives = {};
+    for (auto mount : mounts) {
+        archives.push_back(mount->archive);
+    }
+
+    return archives;
+}
+
+size_t evp_vfs::size() const {
+    std::shared_lock<std::shared_mutex> guard(m_mutex);
+    return m_index.size();
+}
+
+evp_result evp_vfs::find(const FILE_PATH& file, entry& entry) const {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    std::shared_lock<std::shared_mutex> guard(m_mutex);
+
+    auto it = m_index.find(to_fd_name(file));
+    if (it == m_index.end()) {
+        result.message = EVP_STR_FORMAT("File not found.");
+        return result;
+    }
+
+    entry.archive = it->second.mount->archive;
+    entry.fd      = it->second.mount->files[it->second.index];
+
+    result.status = evp_result::status::ok;
+    return result;
+}
+
+evp_result evp_vfs::get_file(const FILE_PATH& file, std::vector<uint8_t>& buffer) {
+    evp_result result;
+    result.status = evp_result::status::failure;
+
+    std::shared_lock<std::shared_mutex> guard(m_mutex);
+
+    auto it = m_index.find(to_fd_name(file));
+    if (it == m_index.end()) {
+        result.message = EVP_STR_FORMAT("File not found.");
+        return result;
+    }
+
+    return m_evp.get_file(it->second.mount->archive, it->second.mount->files[it->second.index], buffer);
+}
+
+void evp_vfs::set_cache(std::shared_ptr<evp_cache> cache) {
+    std::unique_lock<std::shared_mutex> guard(m_mutex);
+    m_evp.set_cache(cache);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERNAL
+
+FILE_PATH to_archive_path(const FILE_PATH& archive) {
+    std::error_code ec;
+
+    FILE_PATH path = std::filesystem::absolute(archive, ec);
+    if (ec)
+        return archive.lexically_normal();
+
+    return path.lexically_normal();
+}
@@ -1,7 +1,9 @@
 #pragma once
 
-#include "libevp/model/evp_fd.hpp"
+#include "libevp/model/entry_table.hpp"
 #include "libevp/stream/stream_read.hpp"
+#include "libevp/misc/evp_context_internal.hpp"
+#include "libevp/misc/evp_exception.hpp"
 
 #include <vector>
 #include <memory>
@@ -10,15 +12,15 @@
 
 namespace libevp::format {
     struct file_desc_block {
-        std::vector<evp_fd> files = {};
+        entry_table files = {};
     };
     
     struct format {
         using ptr_t          = std::shared_ptr<format>;
-        using data_read_cb_t = std::function<void(uint8_t*, uint32_t)>;
+        using data_read_cb_t = std::function<void(const uint8_t*, uint32_t)>;
 
-        uint32_t file_desc_block_offset = 0U;
-        uint32_t file_desc_block_size   = 0U;
+        uint64_t file_desc_block_offset = 0U;
+        uint64_t file_desc_block_size   = 0U;
         uint32_t file_count             = 0U;
         uint32_t _unk_1                 = 0U;
 
@@ -26,8 +28,64 @@ namespace libevp::format {
 
         std::shared_ptr<file_desc_block> desc_block;
 
-        virtual void read_format_desc(libevp::fstream_read& stream)                                        = 0;
-        virtual void read_file_desc_block(libevp::fstream_read& stream)                                    = 0;
-        virtual void read_file_data(libevp::fstream_read& stream, evp_fd& fd, data_read_cb_t cb = nullptr) = 0;
+        /*
+            Optional context, checked for cancellation once per data chunk
+            and used to collect stats and trace spans.
+        */
+        const evp_context_internal* context = nullptr;
+
+        /*
+            Throw evp_cancelled_exception if context was cancelled.
+        */
+        void check_cancelled() const {
+            if (context && context->is_cancelled())
+                throw evp_cancelled_exception();
+        }
+
+        /*
+            Get stats to fill in, nullptr if not set.
+        */
+        evp_stats* get_stats() const {
+            return context ? context->get_stats() : nullptr;
+        }
+
+        /*
+            Get trace to record spans to, nullptr if not set.
+        */
+        evp_trace* get_trace() const {
+            return context ? context->get_trace() : nullptr;
+        }
+
+        /*
+            Get size of archive header, entry data can't start before it.
+        */
+        virtual uint64_t get_format_desc_size() const = 0;
+
+        virtual void read_format_desc(libevp::source_read& stream)                                                   = 0;
+        virtual void read_file_desc_block(libevp::source_read& stream)                                               = 0;
+        virtual void read_file_data(libevp::source_read& stream, const evp_fd_view& fd, data_read_cb_t cb = nullptr) = 0;
+
+        /*
+            Check if entry data is stored as is, data_size bytes at data_offset,
+            so it can be copied out of the archive without going through read_file_data.
+        */
+        virtual bool is_stored(libevp::source_read& stream, const evp_fd_view& fd) {
+            return false;
+        }
+
+        /*
+            Get number of bytes entry data takes up inside the archive.
+        */
+        virtual uint64_t get_data_size_in_archive(const evp_fd_view& fd) const {
+            return fd.data_compressed_size;
+        }
+
+        /*
+            Cheap check of entry data that doesn't decode it, e.g. compressed stream header.
+            Entries that have nothing to check pass.
+        */
+        virtual bool check_data_start(libevp::source_read& stream, const evp_fd_view& fd) {
+            return true;
+        }
     };
 }
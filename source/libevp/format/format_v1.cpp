@@ -1,4 +1,6 @@
 #include "libevp/format/format_v1.hpp"
+#include "libevp/misc/trace_span.hpp"
+#include "libevp/misc/evp_exception.hpp"
 #include "libevp/defs.hpp"
 
 #include <array>
@@ -20,7 +22,7 @@ libevp::format::v1::format::format() {
     desc_block = std::make_shared<libevp::format::v1::file_desc_block>();
 }
 
-void libevp::format::v1::format::read_format_desc(libevp::fstream_read& stream) {
+void libevp::format::v1::format::read_format_desc(libevp::source_read& stream) {
     std::array<uint8_t, sizeof(HEADER)> header = {};
 
     stream.seek(0, std::ios::beg);
@@ -31,25 +33,37 @@ void libevp::format::v1::format::read_format_desc(libevp::fstream_read& stream)
             return;
     }
 
-    format_type            = static_cast<format::type>(stream.read<uint32_t>());
-    file_desc_block_offset = stream.read<uint32_t>();
-    file_desc_block_size   = stream.read<uint32_t>();
-    file_count             = stream.read<uint32_t>();
-    _unk_1                 = stream.read<uint32_t>();
+    format_type = static_cast<format::type>(stream.read<uint32_t>());
 
     switch (format_type) {
-        case format::type::v100: break;
+        case format::type::v100:
+        case format::type::v100_64: break;
         default: return;
     }
 
+    if (is_wide()) {
+        file_desc_block_offset = stream.read<uint64_t>();
+        file_desc_block_size   = stream.read<uint64_t>();
+    }
+    else {
+        file_desc_block_offset = stream.read<uint32_t>();
+        file_desc_block_size   = stream.read<uint32_t>();
+    }
+
+    file_count = stream.read<uint32_t>();
+    _unk_1     = stream.read<uint32_t>();
+
     is_valid = true;
 }
 
-void libevp::format::v1::format::read_file_desc_block(libevp::fstream_read& stream) {
+void libevp::format::v1::format::read_file_desc_block(libevp::source_read& stream) {
     if (!desc_block) return;
 
     file_desc_block_ptr_t block = static_pointer_cast<file_desc_block>(desc_block);
 
+    if (file_desc_block_offset > stream.size() || file_desc_block_size > stream.size() - file_desc_block_offset)
+        throw evp_exception("File desc block is outside archive.");
+
     stream.seek(file_desc_block_offset, std::ios::beg);
 
     block->region_name_size = stream.read<uint32_t>();
@@ -58,24 +72,39 @@ void libevp::format::v1::format::read_file_desc_block(libevp::fstream_read& stre
     block->_unk_2           = stream.read<uint32_t>();
     block->_unk_3           = stream.read<uint32_t>();
 
+    std::string             name = "";
+    std::array<uint8_t, 16> hash = {};
+
+    // descriptors are at least 44 (56 if wide) bytes, don't trust file count alone
+    uint64_t min_fd_size = is_wide() ? 56U : 44U;
+    uint64_t left        = std::min(file_desc_block_size, stream.size() - stream.pos());
+    bool     wide        = is_wide();
+
+    block->files.clear();
+    block->files.reserve((size_t)std::min<uint64_t>(file_count, left / min_fd_size), (size_t)left);
+
     for (uint64_t i = 0; i < file_count; i++) {
-        evp_fd fd;
+        evp_fd_view fd;
 
         // name size
         uint32_t name_size = stream.read<uint32_t>();
 
         // name
-        fd.file = stream.read(name_size);
-        std::replace(fd.file.begin(), fd.file.end(), '\\', '/');
-
-        // data offset
-        fd.data_offset = stream.read<uint32_t>();
-
-        // compressed data size
-        fd.data_compressed_size = stream.read<uint32_t>();
-
-        // data size
-        fd.data_size = stream.read<uint32_t>();
+        name.resize(name_size);
+        stream.read((uint8_t*)name.data(), name_size);
+        std::replace(name.begin(), name.end(), '\\', '/');
+        fd.file = name;
+
+        if (wide) {
+            fd.data_offset          = stream.read<uint64_t>();
+            fd.data_compressed_size = stream.read<uint64_t>();
+            fd.data_size            = stream.read<uint64_t>();
+        }
+        else {
+            fd.data_offset          = stream.read<uint32_t>();
+            fd.data_compressed_size = stream.read<uint32_t>();
+            fd.data_size            = stream.read<uint32_t>();
+        }
 
         // flags
         fd.flags = stream.read<uint32_t>();
@@ -84,66 +113,173 @@ void libevp::format::v1::format::read_file_desc_block(libevp::fstream_read& stre
         stream.seek(0x8);
 
         // hash
-        stream.read(fd.hash.data(), (uint32_t)fd.hash.size());
+        stream.read(hash.data(), (uint32_t)hash.size());
+        fd.hash = hash.data();
 
         block->files.push_back(fd);
     }
 }
 
-void libevp::format::v1::format::read_file_data(libevp::fstream_read& stream, evp_fd& fd, data_read_cb_t cb) {
+void libevp::format::v1::format::read_file_data(libevp::source_read& stream, const evp_fd_view& fd, data_read_cb_t cb) {
     stream.seek(fd.data_offset, std::ios::beg);
 
     buffer_t buffer = {};
-    buffer.resize(EVP_READ_CHUNK_SIZE);
+    if (!stream.data())
+        buffer.resize(EVP_READ_CHUNK_SIZE);
+
+    evp_stats* stats = get_stats();
+    evp_trace* trace = get_trace();
 
-    uint32_t left_to_read = fd.data_size;
+    uint64_t left_to_read = fd.data_size;
     while (left_to_read > 0) {
-        uint32_t read_count = (uint32_t)std::min(left_to_read, EVP_READ_CHUNK_SIZE);
+        check_cancelled();
+
+        uint32_t       read_count = (uint32_t)std::min<uint64_t>(left_to_read, EVP_READ_CHUNK_SIZE);
+        const uint8_t* data       = nullptr;
+
+        {
+            trace_span span(trace, "read", "io", fd.data_offset);
+
+            // stored data, pass in-memory sources through without copying
+            data = stream.view(read_count);
+            if (!data) {
+                stream.read(buffer.data(), read_count);
+                data = buffer.data();
+            }
+        }
+
+        if (stats)
+            stats->add_bytes_read(read_count);
 
-        stream.read(buffer.data(), read_count);
         if (cb)
-            cb(buffer.data(), read_count);
+            cb(data, read_count);
 
         left_to_read -= read_count;
     }
 }
 
-void libevp::format::v1::format::write_format_desc(libevp::fstream_write& stream) {
-    stream.seek(0, std::ios::beg);
+bool libevp::format::v1::format::is_stored(libevp::source_read& stream, const evp_fd_view& fd) {
+    return true;
+}
+
+uint64_t libevp::format::v1::format::get_data_size_in_archive(const evp_fd_view& fd) const {
+    return fd.data_size;
+}
+
+void libevp::format::v1::format::write_format_desc(libevp::sink_write& stream) {
+    buffer_t     buffer = {};
+    stream_write header(buffer);
+
+    buffer.reserve(sizeof(HEADER) + 28U);
+
+    header.write((uint8_t*)HEADER, sizeof(HEADER));
+    if (is_wide()) {
+        header.write(format::type::v100_64);
+        header.write(file_desc_block_offset);
+        header.write(file_desc_block_size);
+    }
+    else {
+        header.write(format::type::v100);
+        header.write((uint32_t)file_desc_block_offset);
+        header.write((uint32_t)file_desc_block_size);
+    }
+
+    header.write(file_count);
+    header.write(_unk_1);
 
-    stream.write((uint8_t*)HEADER, (uint32_t)sizeof(HEADER));
-    stream.write(format::type::v100);
-    stream.write(file_desc_block_offset);
-    stream.write(file_desc_block_size);
-    stream.write(file_count);
-    stream.write(_unk_1);
+    stream.seek(0, std::ios::beg);
+    stream.write(buffer.data(), buffer.size());
 }
 
-void libevp::format::v1::format::write_file_desc_block(libevp::fstream_write& stream) {
+void libevp::format::v1::format::write_file_desc_block(libevp::sink_write& stream) {
     if (!desc_block) return;
 
     file_desc_block_ptr_t block = static_pointer_cast<file_desc_block>(desc_block);
 
-    stream.seek(file_desc_block_offset, std::ios::beg);   
-    file_desc_block_size = (uint32_t)stream.pos();
+    // serialize whole block, then write it at once
+    buffer_t     buffer = {};
+    stream_write desc(buffer);
+
+    buffer.reserve(get_file_desc_block_size());
     
-    stream.write(block->region_name);
-    stream.write(block->_unk_1);
-    stream.write(block->_unk_2);
-    stream.write(block->_unk_3);
+    desc.write(block->region_name);
+    desc.write(block->_unk_1);
+    desc.write(block->_unk_2);
+    desc.write(block->_unk_3);
+
+    for (size_t i = 0; i < block->files.size(); i++) {
+        evp_fd_view fd = block->files[i];
+
+        desc.write(fd.file);
+
+        if (is_wide()) {
+            desc.write(fd.data_offset);
+            desc.write(fd.data_size);
+            desc.write(fd.data_size);
+        }
+        else {
+            desc.write((uint32_t)fd.data_offset);
+            desc.write((uint32_t)fd.data_size);
+            desc.write((uint32_t)fd.data_size);
+        }
+
+        desc.write((uint32_t)0x00000001);
+        desc.write((uint32_t)0x00000000);
+        desc.write((uint32_t)0x00000000);
+        desc.write(fd.hash, 16U);
+    }
+
+    stream.seek(file_desc_block_offset, std::ios::beg);
+    stream.write(buffer.data(), buffer.size());
+
+    file_desc_block_size = (uint64_t)buffer.size();
+}
+
+uint64_t libevp::format::v1::format::get_file_desc_block_size() const {
+    if (!desc_block) return 0U;
+
+    file_desc_block_ptr_t block = static_pointer_cast<file_desc_block>(desc_block);
+
+    uint64_t fd_size = is_wide() ? 52U : 40U;
+    uint64_t size    = 16U + block->region_name.size();
 
     for (size_t i = 0; i < block->files.size(); i++) {
-        evp_fd& fd = block->files[i];
-
-        stream.write(fd.file);
-        stream.write(fd.data_offset);
-        stream.write(fd.data_size);
-        stream.write(fd.data_size);
-        stream.write((uint32_t)0x00000001);
-        stream.write((uint32_t)0x00000000);
-        stream.write((uint32_t)0x00000000);
-        stream.write(fd.hash.data(), (uint32_t)fd.hash.size());
+        size += 4U + block->files.file(i).size() + fd_size;
+    }
+
+    return size;
+}
+
+void libevp::format::v1::format::plan_layout(uint64_t alignment, uint64_t alignment_threshold) {
+    if (!desc_block) return;
+
+    entry_table& files = desc_block->files;
+
+    // padding is skipped by readers since entries are only reached through their offsets
+    auto assign_offsets = [&]() {
+        uint64_t data_offset = get_format_desc_size();
+
+        for (size_t i = 0; i < files.size(); i++) {
+            if (alignment > 1U && files.data_size(i) >= alignment_threshold)
+                data_offset = (data_offset + alignment - 1U) & ~(alignment - 1U);
+
+            files.set_data_offset(i, data_offset);
+            data_offset += files.data_size(i);
+        }
+
+        return data_offset;
+    };
+
+    format_type = format::type::v100;
+
+    uint64_t data_end = assign_offsets();
+
+    if (data_end > UINT32_MAX || get_file_desc_block_size() > UINT32_MAX) {
+        format_type = format::type::v100_64;
+        data_end    = assign_offsets();
     }
 
-    file_desc_block_size = (uint32_t)stream.pos() - file_desc_block_size;
+    file_desc_block_offset = data_end;
+    file_desc_block_size   = get_file_desc_block_size();
+    file_count             = (uint32_t)files.size();
 }
@@ -21,21 +21,61 @@ namespace libevp::format::v1 {
 
         enum class type : uint32_t {
             undefined = 0x00000000,
-            v100      = 0x00000064
+            v100      = 0x00000064,
+
+            /*
+                libevp specific extended container.
+                Same layout as v100 except desc block offset/size in the header
+                and entry data offset/sizes are 64-bit.
+            */
+            v100_64   = 0x00010064
         };
 
     public:
         format::type format_type = format::type::undefined;
 
+    public:
+
+        /*
+            Check if format uses 64-bit offsets and sizes.
+        */
+        bool is_wide() const {
+            return format_type == format::type::v100_64;
+        }
+
+        /*
+            Get size of format desc as written by write_format_desc.
+        */
+        uint64_t get_format_desc_size() const override final {
+            return is_wide() ? 84U : 76U;
+        }
+
+        /*
+            Get size of file desc block as written by write_file_desc_block.
+        */
+        uint64_t get_file_desc_block_size() const;
+
+        /*
+            Assign entry data offsets, desc block offset/size and file count
+            from entry sizes. Switches to the 64-bit container if the 32-bit
+            layout would overflow.
+
+            @param alignment           -> power of two boundary entry data is aligned to, 0 to pack back to back
+            @param alignment_threshold -> smallest entry size that is aligned
+        */
+        void plan_layout(uint64_t alignment = 0U, uint64_t alignment_threshold = 0U);
+
     public:
         format();
         
     public:
-        void read_format_desc(libevp::fstream_read& stream)                                        override final;
-        void read_file_desc_block(libevp::fstream_read& stream)                                    override final;
-        void read_file_data(libevp::fstream_read& stream, evp_fd& fd, data_read_cb_t cb = nullptr) override final;
+        void read_format_desc(libevp::source_read& stream)                                                   override final;
+        void read_file_desc_block(libevp::source_read& stream)                                               override final;
+        void read_file_data(libevp::source_read& stream, const evp_fd_view& fd, data_read_cb_t cb = nullptr) override final;
+        bool is_stored(libevp::source_read& stream, const evp_fd_view& fd)                                   override final;
+        uint64_t get_data_size_in_archive(const evp_fd_view& fd) const                                       override final;
 
-        void write_format_desc(libevp::fstream_write& stream);
-        void write_file_desc_block(libevp::fstream_write& stream);
+        void write_format_desc(libevp::sink_write& stream);
+        void write_file_desc_block(libevp::sink_write& stream);
     };
 }
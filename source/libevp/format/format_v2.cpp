@@ -1,6 +1,9 @@
 #include "libevp/format/format_v2.hpp"
+#include "libevp/format/format_v2_kernels.hpp"
 #include "libevp/stream/stream_write.hpp"
 #include "libevp/misc/evp_exception.hpp"
+#include "libevp/misc/stats_timer.hpp"
+#include "libevp/misc/trace_span.hpp"
 #include "libevp/defs.hpp"
 
 #include <miniz/miniz.h>
@@ -10,14 +13,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 // INTERNAL
 
-// TEA encoded size
-constexpr uint32_t TEA_CHUNK_SIZE = 64;
-
-// zlib input buffer size (same as non-obfuscated input size)
-constexpr uint32_t ZLIB_IN_CHUNK_SIZE = libevp::EVP_READ_CHUNK_SIZE;
-
-// zlib decompress buffer size
-constexpr uint32_t ZLIB_OUT_CHUNK_SIZE = ZLIB_IN_CHUNK_SIZE * 4;
+using libevp::format::v2::TEA_CHUNK_SIZE;
+using libevp::format::v2::ZLIB_IN_CHUNK_SIZE;
+using libevp::format::v2::ZLIB_OUT_CHUNK_SIZE;
+using libevp::format::v2::decode_block;
+using libevp::format::v2::zlib_check_magic;
+using libevp::format::v2::zlib_decompress_block;
 
 constexpr uint8_t HEADER[56] = {
     0x35, 0x32, 0x35, 0x63, 0x31, 0x37, 0x61, 0x36, 0x61, 0x37, 0x63, 0x66, 0x62, 0x63,
@@ -38,6 +39,20 @@ struct obfuscation {
     uint32_t decompressed_size = 0U;
 };
 
+/*
+    Ends an initialized inflate stream when leaving scope,
+    data callbacks and cancellation can throw mid-stream.
+*/
+struct inflate_guard {
+    mz_stream& stream;
+    bool       active = false;
+
+    ~inflate_guard() {
+        if (active)
+            mz_inflateEnd(&stream);
+    }
+};
+
 /*
     Read possibly obfuscated block.
     
@@ -53,29 +68,8 @@ struct obfuscation {
     Possible compressions:
       - zlib
 */
-static void read_obfuscated_block(libevp::fstream_read& stream, obfuscation& obfuscation,
-    libevp::format::format::data_read_cb_t cb);
-
-/*
-    Decode 64 bytes of the block.
-*/
-static void decode_block(uint8_t* block, uint32_t block_size);
-
-/*
-    Check for zlib magic.
-*/
-static bool zlib_check_magic(uint8_t* data, uint32_t size);
-
-/*
-    Decompress zlib block.
-*/
-static int zlib_decompress_block(mz_stream& stream, uint8_t* src, uint32_t src_size,
-    uint8_t* dst, uint32_t dst_size, libevp::format::format::data_read_cb_t cb);
-
-/*
-    TEA algorithm decode.
-*/
-static void TEA_decode(uint8_t input[8], uint8_t output[8], uint32_t* key);
+static void read_obfuscated_block(libevp::source_read& stream, obfuscation& obfuscation,
+    libevp::format::format::data_read_cb_t cb, const libevp::format::format* format = nullptr);
 
 ////////////////////////////////////////////////////////////////////////////////
 // PUBLIC
@@ -84,7 +78,7 @@ libevp::format::v2::format::format() {
     desc_block = std::make_shared<libevp::format::v2::file_desc_block>();
 }
 
-void libevp::format::v2::format::read_format_desc(libevp::fstream_read& stream) {
+void libevp::format::v2::format::read_format_desc(libevp::source_read& stream) {
     std::array<uint8_t, sizeof(HEADER)> header = {};
 
     stream.seek(0, std::ios::beg);
@@ -110,7 +104,7 @@ void libevp::format::v2::format::read_format_desc(libevp::fstream_read& stream)
     is_valid = true;
 }
 
-void libevp::format::v2::format::read_file_desc_block(libevp::fstream_read& stream) {
+void libevp::format::v2::format::read_file_desc_block(libevp::source_read& stream) {
     if (!desc_block) return;
 
     file_desc_block_ptr_t block = static_pointer_cast<file_desc_block>(desc_block);
@@ -131,7 +125,7 @@ void libevp::format::v2::format::read_file_desc_block(libevp::fstream_read& stre
     obfuscation.compressed_size   = block->compressed_size;
     obfuscation.decompressed_size = block->size;
 
-    read_obfuscated_block(stream, obfuscation, [&](uint8_t* data, uint32_t size) {
+    read_obfuscated_block(stream, obfuscation, [&](const uint8_t* data, uint32_t size) {
         buffer.insert(buffer.end(), data, data + size);
     });
 
@@ -146,15 +140,24 @@ void libevp::format::v2::format::read_file_desc_block(libevp::fstream_read& stre
     block->_unk_2           = block_stream.read<uint32_t>();
     block->_unk_3           = block_stream.read<uint32_t>();
 
+    std::string             name = "";
+    std::array<uint8_t, 16> hash = {};
+
+    // descriptors are at least 44 bytes, don't trust file count alone
+    block->files.clear();
+    block->files.reserve(std::min<size_t>(file_count, block->size / 44), block->size);
+
     for (uint64_t i = 0; i < file_count; i++) {
-        evp_fd fd;
+        evp_fd_view fd;
 
         // name size
         uint32_t name_size = block_stream.read<uint32_t>();
 
         // name
-        fd.file = block_stream.read(name_size);
-        std::replace(fd.file.begin(), fd.file.end(), '\\', '/');
+        name.resize(name_size);
+        block_stream.read((uint8_t*)name.data(), name_size);
+        std::replace(name.begin(), name.end(), '\\', '/');
+        fd.file = name;
 
         // data offset
         fd.data_offset = block_stream.read<uint32_t>();
@@ -172,34 +175,80 @@ void libevp::format::v2::format::read_file_desc_block(libevp::fstream_read& stre
         block_stream.seek(0x8);
 
         // hash
-        block_stream.read(fd.hash.data(), (uint32_t)fd.hash.size());
+        block_stream.read(hash.data(), (uint32_t)hash.size());
+        fd.hash = hash.data();
 
         block->files.push_back(fd);
     }
 }
 
-void libevp::format::v2::format::read_file_data(libevp::fstream_read& stream, evp_fd& fd, data_read_cb_t cb) {
+void libevp::format::v2::format::read_file_data(libevp::source_read& stream, const evp_fd_view& fd, data_read_cb_t cb) {
     obfuscation obfuscation       = {};
     obfuscation.encoded           = fd.flags & 4;
     obfuscation.compressed        = fd.data_size != fd.data_compressed_size;
-    obfuscation.compressed_size   = fd.data_compressed_size;
-    obfuscation.decompressed_size = fd.data_size;
+    obfuscation.compressed_size   = (uint32_t)fd.data_compressed_size;
+    obfuscation.decompressed_size = (uint32_t)fd.data_size;
+
+    stream.seek(fd.data_offset, std::ios::beg);
+
+    read_obfuscated_block(stream, obfuscation, cb, this);
+}
+
+bool libevp::format::v2::format::is_stored(libevp::source_read& stream, const evp_fd_view& fd) {
+    if ((fd.flags & 4) || fd.data_size != fd.data_compressed_size)
+        return false;
+
+    if (fd.data_size < 2)
+        return true;
+
+    uint8_t magic[2] = {};
 
     stream.seek(fd.data_offset, std::ios::beg);
+    stream.read(magic, sizeof(magic));
 
-    read_obfuscated_block(stream, obfuscation, cb);
+    // compression that is not obvious by the size difference
+    return !zlib_check_magic(magic, sizeof(magic));
+}
+
+uint64_t libevp::format::v2::format::get_format_desc_size() const {
+    // header + 5 * uint32_t
+    return sizeof(HEADER) + 20U;
+}
+
+bool libevp::format::v2::format::check_data_start(libevp::source_read& stream, const evp_fd_view& fd) {
+    // encoded data has to be decoded first, raw data has no header
+    if ((fd.flags & 4) || fd.data_size == fd.data_compressed_size)
+        return true;
+
+    if (fd.data_compressed_size < 2)
+        return false;
+
+    uint8_t magic[2] = {};
+
+    stream.seek(fd.data_offset, std::ios::beg);
+    stream.read(magic, sizeof(magic));
+
+    return zlib_check_magic(magic, sizeof(magic));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // INTERNAL
 
-void read_obfuscated_block(libevp::fstream_read& stream, obfuscation& obfuscation, libevp::format::format::data_read_cb_t cb) {
+void read_obfuscated_block(libevp::source_read& stream, obfuscation& obfuscation, libevp::format::format::data_read_cb_t cb,
+    const libevp::format::format* format)
+{
     libevp::buffer_t read_buf = {};
     read_buf.resize(ZLIB_IN_CHUNK_SIZE);
 
     libevp::buffer_t decomp_buf = {};
     decomp_buf.resize(ZLIB_OUT_CHUNK_SIZE);
 
+    libevp::evp_stats* stats = format ? format->get_stats() : nullptr;
+    libevp::evp_trace* trace = format ? format->get_trace() : nullptr;
+
+    // bind spans to the block's entry
+    uint64_t data_offset = (uint64_t)stream.pos();
+
     uint32_t left_to_read = obfuscation.compressed_size;
     uint32_t read_count   = 0U;
 
@@ -208,13 +257,23 @@ void read_obfuscated_block(libevp::fstream_read& stream, obfuscation& obfuscatio
     */
 
     read_count = (uint32_t)std::min(left_to_read, ZLIB_IN_CHUNK_SIZE);
-    stream.read(read_buf.data(), read_count);
+
+    {
+        libevp::trace_span span(trace, "read", "io", data_offset);
+        stream.read(read_buf.data(), read_count);
+    }
+
+    if (stats)
+        stats->add_bytes_read(read_count);
 
     if (obfuscation.encoded) {
+        libevp::stats_timer timer(stats, libevp::evp_stats::phase::tea);
+        libevp::trace_span  span(trace, "decode", "codec", data_offset);
         decode_block(read_buf.data(), read_count);
     }
 
-    mz_stream mstream{};
+    mz_stream     mstream{};
+    inflate_guard guard{ mstream };
 
     /*
         Detect compression that was not obvious by the size difference.
@@ -234,48 +293,55 @@ void read_obfuscated_block(libevp::fstream_read& stream, obfuscation& obfuscatio
 
         if (mz_inflateInit(&mstream) != Z_OK)
             throw libevp::evp_exception("Failed to init inflate stream.");
+
+        guard.active = true;
     }
 
     do {
         left_to_read -= read_count;
 
+        if (format)
+            format->check_cancelled();
+
         if (obfuscation.compressed) {
             int res = zlib_decompress_block(mstream, read_buf.data(),
-                read_count, decomp_buf.data(), ZLIB_OUT_CHUNK_SIZE, cb);
+                read_count, decomp_buf.data(), ZLIB_OUT_CHUNK_SIZE, cb, stats, trace);
 
             if (res == Z_STREAM_END)
                 break;
 
-            if (res != 0) {
-                mz_inflateEnd(&mstream);
+            if (res != 0)
                 throw libevp::evp_exception("Failed during decompress.");
-            }
         }
         else {
             cb(read_buf.data(), read_count);
         }
 
         read_count = (uint32_t)std::min(left_to_read, ZLIB_IN_CHUNK_SIZE);
-        stream.read(read_buf.data(), read_count);
+
+        {
+            libevp::trace_span span(trace, "read", "io", data_offset);
+            stream.read(read_buf.data(), read_count);
+        }
+
+        if (stats)
+            stats->add_bytes_read(read_count);
 
     } while (left_to_read > 0);
 
     if (obfuscation.compressed) {
-        if (mstream.total_in != obfuscation.compressed_size) {
-            mz_inflateEnd(&mstream);
+        if (mstream.total_in != obfuscation.compressed_size)
             throw libevp::evp_exception("Failed to decompress. Input not fully read.");
-        }
 
-        if (mstream.total_out != obfuscation.decompressed_size) {
-            mz_inflateEnd(&mstream);
+        if (mstream.total_out != obfuscation.decompressed_size)
             throw libevp::evp_exception("Failed to decompress. Output size wrong.");
-        }
-
-        mz_inflateEnd(&mstream);
     }
 }
 
-void decode_block(uint8_t* block, uint32_t block_size) {
+////////////////////////////////////////////////////////////////////////////////
+// KERNELS
+
+void libevp::format::v2::decode_block(uint8_t* block, uint32_t block_size) {
     uint32_t decode_size = TEA_CHUNK_SIZE;
 
     if (TEA_CHUNK_SIZE >= block_size) {
@@ -291,7 +357,7 @@ void decode_block(uint8_t* block, uint32_t block_size) {
     }
 }
 
-bool zlib_check_magic(uint8_t* data, uint32_t size) {
+bool libevp::format::v2::zlib_check_magic(uint8_t* data, uint32_t size) {
     if (size < 2) return false;
 
     if (data[0] != 0x78)
@@ -307,8 +373,9 @@ bool zlib_check_magic(uint8_t* data, uint32_t size) {
     Adapted from zlib examples.
     https://github.com/madler/zlib/blob/51b7f2abdade71cd9bb0e7a373ef2610ec6f9daf/examples/zpipe.c#L92
 */
-int zlib_decompress_block(mz_stream& stream, uint8_t* src, uint32_t src_size,
-    uint8_t* dst, uint32_t dst_size, libevp::format::format::data_read_cb_t cb)
+int libevp::format::v2::zlib_decompress_block(mz_stream& stream, uint8_t* src, uint32_t src_size,
+    uint8_t* dst, uint32_t dst_size, libevp::format::format::data_read_cb_t cb, libevp::evp_stats* stats,
+    libevp::evp_trace* trace)
 {
     if (src_size == 0)
         return Z_DATA_ERROR;
@@ -323,7 +390,12 @@ int zlib_decompress_block(mz_stream& stream, uint8_t* src, uint32_t src_size,
         stream.avail_out = dst_size;
         stream.next_out  = dst;
 
-        retval = inflate(&stream, Z_NO_FLUSH);
+        {
+            libevp::stats_timer timer(stats, libevp::evp_stats::phase::decompress);
+            libevp::trace_span  span(trace, "inflate", "codec");
+            retval = inflate(&stream, Z_NO_FLUSH);
+        }
+
         if (retval == Z_STREAM_ERROR)
             return retval;
 
@@ -343,7 +415,7 @@ int zlib_decompress_block(mz_stream& stream, uint8_t* src, uint32_t src_size,
     return retval;
 }
 
-void TEA_decode(uint8_t input[8], uint8_t output[8], uint32_t* key) {
+void libevp::format::v2::TEA_decode(uint8_t input[8], uint8_t output[8], uint32_t* key) {
     uint32_t delta  = 0x9E3779B9;
     uint32_t sum    = 0xC6EF3720;
     uint32_t cycles = 32;
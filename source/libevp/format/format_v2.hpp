@@ -33,8 +33,11 @@ namespace libevp::format::v2 {
         format();
 
     public:
-        void read_format_desc(libevp::fstream_read& stream)                                        override final;
-        void read_file_desc_block(libevp::fstream_read& stream)                                    override final;
-        void read_file_data(libevp::fstream_read& stream, evp_fd& fd, data_read_cb_t cb = nullptr) override final;
+        void read_format_desc(libevp::source_read& stream)                                                   override final;
+        void read_file_desc_block(libevp::source_read& stream)                                               override final;
+        void read_file_data(libevp::source_read& stream, const evp_fd_view& fd, data_read_cb_t cb = nullptr) override final;
+        bool is_stored(libevp::source_read& stream, const evp_fd_view& fd)                                   override final;
+        bool check_data_start(libevp::source_read& stream, const evp_fd_view& fd)                            override final;
+        uint64_t get_format_desc_size() const                                                                override final;
     };
 }
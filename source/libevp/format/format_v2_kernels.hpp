@@ -0,0 +1,46 @@
+#pragma once
+
+#include "libevp/format/format.hpp"
+#include "libevp/evp_stats.hpp"
+#include "libevp/evp_trace.hpp"
+#include "libevp/defs.hpp"
+
+#include <miniz/miniz.h>
+#include <cstdint>
+
+/*
+    Format v2 decoding kernels.
+    Exposed for reuse and microbenchmarks, the reader is the only user in the library.
+*/
+namespace libevp::format::v2 {
+    // TEA encoded size
+    constexpr uint32_t TEA_CHUNK_SIZE = 64;
+
+    // zlib input buffer size (same as non-obfuscated input size)
+    constexpr uint32_t ZLIB_IN_CHUNK_SIZE = libevp::EVP_READ_CHUNK_SIZE;
+
+    // zlib decompress buffer size
+    constexpr uint32_t ZLIB_OUT_CHUNK_SIZE = ZLIB_IN_CHUNK_SIZE * 4;
+
+    /*
+        Decode 64 bytes of the block.
+    */
+    void decode_block(uint8_t* block, uint32_t block_size);
+
+    /*
+        Check for zlib magic.
+    */
+    bool zlib_check_magic(uint8_t* data, uint32_t size);
+
+    /*
+        Decompress zlib block.
+    */
+    int zlib_decompress_block(mz_stream& stream, uint8_t* src, uint32_t src_size,
+        uint8_t* dst, uint32_t dst_size, libevp::format::format::data_read_cb_t cb, libevp::evp_stats* stats = nullptr,
+        libevp::evp_trace* trace = nullptr);
+
+    /*
+        TEA algorithm decode.
+    */
+    void TEA_decode(uint8_t input[8], uint8_t output[8], uint32_t* key);
+}
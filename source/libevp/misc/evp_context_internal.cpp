@@ -1,26 +1,36 @@
 #include "evp_context_internal.hpp"
+#include "trace_span.hpp"
 
 using namespace libevp;
 
-evp_context_internal::evp_context_internal(evp_context* context)
-    : m_context(context) {}
+evp_context_internal::evp_context_internal(evp_context* context, const std::atomic_bool* job_cancel)
+    : m_context(context), m_job_cancel(job_cancel) {}
 
 void evp_context_internal::invoke_start() const {
-    if (m_context && m_context->start_callback)
+    if (m_context && m_context->start_callback) {
+        trace_span span(m_context->trace, "start_callback", "callback");
         m_context->start_callback();
+    }
 }
 
 void evp_context_internal::invoke_finish(evp_result& result) const {
-    if (m_context && m_context->finish_callback)
+    if (m_context && m_context->finish_callback) {
+        trace_span span(m_context->trace, "finish_callback", "callback");
         m_context->finish_callback(result);
+    }
 }
 
 void evp_context_internal::invoke_update(float change) const {
-    if (m_context && m_context->update_callback)
+    if (m_context && m_context->update_callback) {
+        trace_span span(m_context->trace, "update_callback", "callback");
         m_context->update_callback(change);
+    }
 }
 
 bool evp_context_internal::is_cancelled() const {
+    if (m_job_cancel && m_job_cancel->load())
+        return true;
+
     if (!m_context || !m_context->cancel) return false;
     return m_context->cancel->load();
 }
@@ -31,3 +41,45 @@ void evp_context_internal::invoke_cancel() const {
 
     invoke_finish(result);
 }
+
+evp_stats* evp_context_internal::get_stats() const {
+    return m_context ? m_context->stats : nullptr;
+}
+
+evp_trace* evp_context_internal::get_trace() const {
+    return m_context ? m_context->trace : nullptr;
+}
+
+void evp_context_internal::set_progress_total(uint64_t total) {
+    m_progress_total.store(total, std::memory_order_relaxed);
+}
+
+void evp_context_internal::add_progress(uint64_t bytes) {
+    uint64_t done = m_progress_done.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    if (!m_context || !m_context->progress_callback)
+        return;
+
+    int64_t now      = std::chrono::steady_clock::now().time_since_epoch().count();
+    int64_t last     = m_progress_last_report.load(std::memory_order_relaxed);
+    int64_t interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(m_context->progress_interval).count();
+
+    if (now - last < interval)
+        return;
+
+    // only one thread reports per interval
+    if (!m_progress_last_report.compare_exchange_strong(last, now, std::memory_order_relaxed))
+        return;
+
+    trace_span span(m_context->trace, "progress_callback", "callback");
+    m_context->progress_callback(done, m_progress_total.load(std::memory_order_relaxed));
+}
+
+void evp_context_internal::flush_progress() {
+    if (!m_context || !m_context->progress_callback)
+        return;
+
+    trace_span span(m_context->trace, "progress_callback", "callback");
+    m_context->progress_callback(m_progress_done.load(std::memory_order_relaxed),
+        m_progress_total.load(std::memory_order_relaxed));
+}
@@ -6,7 +6,7 @@ namespace libevp {
     class evp_context_internal {
     public:
         evp_context_internal() = delete;
-        evp_context_internal(evp_context* context);
+        evp_context_internal(evp_context* context, const std::atomic_bool* job_cancel = nullptr);
 
     public:
         void invoke_start() const;
@@ -16,7 +16,38 @@ namespace libevp {
         bool is_cancelled() const;
         void invoke_cancel() const;
 
+        /*
+            Get user stats, nullptr if not set.
+        */
+        evp_stats* get_stats() const;
+
+        /*
+            Get user trace, nullptr if not set.
+        */
+        evp_trace* get_trace() const;
+
+        /*
+            Set total bytes the operation will process.
+        */
+        void set_progress_total(uint64_t total);
+
+        /*
+            Add processed bytes, safe to call from multiple threads.
+            Progress callback is invoked only if the interval elapsed.
+        */
+        void add_progress(uint64_t bytes);
+
+        /*
+            Invoke progress callback with current values.
+        */
+        void flush_progress();
+
     private:
-        evp_context* m_context;
+        evp_context*            m_context;
+        const std::atomic_bool* m_job_cancel;
+
+        std::atomic_uint64_t    m_progress_done        = 0U;
+        std::atomic_uint64_t    m_progress_total       = 0U;
+        std::atomic_int64_t     m_progress_last_report = 0;
     };
 }
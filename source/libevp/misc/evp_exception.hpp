@@ -3,9 +3,18 @@
 #include <stdexcept>
 
 namespace libevp {
-    class evp_exception : std::runtime_error {
+    class evp_exception : public std::runtime_error {
     public:
         evp_exception(const std::string& message)
             : std::runtime_error(message) {}
     };
+
+    /*
+        Thrown from chunk loops when the operation was cancelled.
+    */
+    class evp_cancelled_exception : public evp_exception {
+    public:
+        evp_cancelled_exception()
+            : evp_exception("Cancelled.") {}
+    };
 }
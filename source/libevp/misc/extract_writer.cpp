@@ -0,0 +1,343 @@
+#include "extract_writer.hpp"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/sendfile.h>
+    #include <cerrno>
+#endif
+
+using namespace libevp;
+
+constexpr size_t BUFFER_ALIGNMENT = 4096U;
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+void extract_writer::write(const uint8_t* src, size_t size) {
+    m_written += size;
+
+    if (m_buffer_used + size <= m_buffer_size) {
+        memcpy(m_buffer + m_buffer_used, src, size);
+        m_buffer_used += size;
+        return;
+    }
+
+    flush();
+
+    // writes larger than the buffer skip it
+    if (size >= m_buffer_size) {
+        write_out(src, size);
+        return;
+    }
+
+    memcpy(m_buffer, src, size);
+    m_buffer_used = size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+void extract_writer::flush() {
+    if (m_buffer_used == 0U)
+        return;
+
+    size_t size = m_buffer_used;
+    m_buffer_used = 0U;
+
+    write_out(m_buffer, size);
+}
+
+#if defined(__linux__)
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+extract_writer::extract_writer(const std::filesystem::path& root, size_t buffer_size)
+    : m_root(root), m_buffer_size(buffer_size)
+{
+    m_buffer  = static_cast<uint8_t*>(::operator new(m_buffer_size, std::align_val_t(BUFFER_ALIGNMENT)));
+    m_root_fd = ::open(m_root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+extract_writer::~extract_writer() {
+    if (m_fd != -1) {
+        // errors can't be reported here, call close() to check them
+        try { flush(); } catch (...) {}
+        ::close(m_fd);
+    }
+
+    if (m_dir_fd != -1)
+        ::close(m_dir_fd);
+
+    if (m_src_fd != -1)
+        ::close(m_src_fd);
+
+    if (m_root_fd != -1)
+        ::close(m_root_fd);
+
+    ::operator delete(m_buffer, std::align_val_t(BUFFER_ALIGNMENT));
+}
+
+bool extract_writer::is_valid() const {
+    return m_root_fd != -1;
+}
+
+bool extract_writer::open(std::string_view file, uint64_t size) {
+    close();
+
+    size_t           sep  = file.find_last_of('/');
+    std::string_view dir  = sep == std::string_view::npos ? std::string_view() : file.substr(0, sep);
+    std::string      name = std::string(sep == std::string_view::npos ? file : file.substr(sep + 1));
+
+    // files are usually grouped by directory, keep the last one open
+    if (m_dir_fd == -1 || dir != m_dir) {
+        if (m_dir_fd != -1) {
+            ::close(m_dir_fd);
+            m_dir_fd = -1;
+        }
+
+        m_dir = dir;
+
+        if (!dir.empty()) {
+            if (!create_directories(dir))
+                return false;
+
+            m_dir_fd = ::openat(m_root_fd, m_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (m_dir_fd == -1)
+                return false;
+        }
+    }
+
+    int dir_fd = m_dir_fd != -1 ? m_dir_fd : m_root_fd;
+
+    m_fd = ::openat(dir_fd, name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (m_fd == -1)
+        return false;
+
+    m_file_size = size;
+    m_written   = 0U;
+
+    // best effort, filesystems without support are written normally
+    if (m_file_size != 0U)
+        fallocate(m_fd, 0, 0, (off_t)m_file_size);
+
+    return true;
+}
+
+bool extract_writer::set_source(const std::filesystem::path& archive) {
+    if (m_src_fd != -1)
+        ::close(m_src_fd);
+
+    m_src_fd = ::open(archive.c_str(), O_RDONLY | O_CLOEXEC);
+    return m_src_fd != -1;
+}
+
+bool extract_writer::copy(uint64_t offset, uint64_t size) {
+    if (m_src_fd == -1 || m_fd == -1 || m_copy == copy_mode::none)
+        return false;
+
+    // keep buffered bytes ahead of copied ones
+    flush();
+
+    off_t    src_offset = (off_t)offset;
+    uint64_t left       = size;
+
+    while (left != 0U) {
+        ssize_t ret = -1;
+
+        if (m_copy == copy_mode::copy_file_range)
+            ret = ::copy_file_range(m_src_fd, &src_offset, m_fd, nullptr, (size_t)left, 0);
+        else
+            ret = ::sendfile(m_fd, m_src_fd, &src_offset, (size_t)left);
+
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        // unsupported by kernel or filesystem, fall back for the rest of the run
+        if (ret == -1 && left == size && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+            m_copy = m_copy == copy_mode::copy_file_range ? copy_mode::sendfile : copy_mode::none;
+
+            if (m_copy == copy_mode::none)
+                return false;
+
+            continue;
+        }
+
+        if (ret <= 0)
+            throw std::runtime_error("Failed to write requested size.");
+
+        left      -= (uint64_t)ret;
+        m_written += (uint64_t)ret;
+    }
+
+    return true;
+}
+
+void extract_writer::close() {
+    if (m_fd == -1)
+        return;
+
+    int fd = m_fd;
+
+    try {
+        flush();
+    }
+    catch (...) {
+        ::close(fd);
+        m_fd = -1;
+        throw;
+    }
+
+    m_fd = -1;
+
+    // drop preallocated tail if less was written than expected
+    bool ok = m_written == m_file_size || ftruncate(fd, (off_t)m_written) == 0;
+
+    if (::close(fd) != 0 || !ok)
+        throw std::runtime_error("Failed to write requested size.");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+bool extract_writer::create_directories(std::string_view dir) {
+    if (m_created_dirs.contains(std::string(dir)))
+        return true;
+
+    size_t sep = 0U;
+
+    while (sep != std::string_view::npos) {
+        sep = dir.find('/', sep + 1);
+
+        std::string path = std::string(dir.substr(0, sep));
+        if (path.empty() || m_created_dirs.contains(path))
+            continue;
+
+        if (::mkdirat(m_root_fd, path.c_str(), 0777) == 0)
+            ::fchmodat(m_root_fd, path.c_str(), 0777, 0);
+        else if (errno != EEXIST)
+            return false;
+
+        m_created_dirs.insert(std::move(path));
+    }
+
+    return true;
+}
+
+void extract_writer::write_out(const uint8_t* src, size_t size) {
+    while (size != 0U) {
+        ssize_t ret = ::write(m_fd, src, size);
+
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        if (ret <= 0)
+            throw std::runtime_error("Failed to write requested size.");
+
+        src  += ret;
+        size -= (size_t)ret;
+    }
+}
+
+#else
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC
+
+extract_writer::extract_writer(const std::filesystem::path& root, size_t buffer_size)
+    : m_root(root), m_buffer_size(buffer_size)
+{
+    m_buffer = static_cast<uint8_t*>(::operator new(m_buffer_size, std::align_val_t(BUFFER_ALIGNMENT)));
+}
+
+extract_writer::~extract_writer() {
+    if (m_stream) {
+        // errors can't be reported here, call close() to check them
+        try { flush(); } catch (...) {}
+        m_stream = nullptr;
+    }
+
+    ::operator delete(m_buffer, std::align_val_t(BUFFER_ALIGNMENT));
+}
+
+bool extract_writer::is_valid() const {
+    return std::filesystem::is_directory(m_root);
+}
+
+bool extract_writer::open(std::string_view file, uint64_t size) {
+    close();
+
+    size_t sep = file.find_last_of('/');
+    if (sep != std::string_view::npos && !create_directories(file.substr(0, sep)))
+        return false;
+
+    m_stream = std::make_unique<fstream_write>(m_root / file);
+    if (!m_stream->is_valid()) {
+        m_stream = nullptr;
+        return false;
+    }
+
+    m_file_size = size;
+    m_written   = 0U;
+
+    m_stream->preallocate(m_file_size);
+    return true;
+}
+
+bool extract_writer::set_source(const std::filesystem::path& archive) {
+    return false;
+}
+
+bool extract_writer::copy(uint64_t offset, uint64_t size) {
+    return false;
+}
+
+void extract_writer::close() {
+    if (!m_stream)
+        return;
+
+    try {
+        flush();
+        m_stream->flush();
+    }
+    catch (...) {
+        m_stream = nullptr;
+        throw;
+    }
+
+    m_stream = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE
+
+bool extract_writer::create_directories(std::string_view dir) {
+    std::string key = std::string(dir);
+    if (m_created_dirs.contains(key))
+        return true;
+
+    std::filesystem::path path = m_root / dir;
+    std::error_code       ec;
+
+    if (!std::filesystem::is_directory(path, ec)) {
+        std::filesystem::create_directories(path, ec);
+        if (ec) return false;
+
+        std::filesystem::permissions(path, std::filesystem::perms::all, ec);
+    }
+
+    m_created_dirs.insert(std::move(key));
+    return true;
+}
+
+void extract_writer::write_out(const uint8_t* src, size_t size) {
+    m_stream->write(src, size);
+}
+
+#endif
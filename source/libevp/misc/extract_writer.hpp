@@ -0,0 +1,114 @@
+#pragma once
+
+#include "libevp/stream/stream_write.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <filesystem>
+#include <unordered_set>
+
+namespace libevp {
+    /*
+        Writes unpacked files under an output directory.
+
+        Remembers created directories so each one is created once,
+        preallocates files to their final size and writes them
+        through one page aligned buffer shared by all files.
+        Stored entries can be copied from the archive inside the kernel.
+    */
+    class extract_writer {
+    public:
+        extract_writer()                      = delete;
+        extract_writer(const extract_writer&) = delete;
+        extract_writer(extract_writer&&)      = delete;
+
+        /*
+            @param root        -> existing directory files are written under
+            @param buffer_size -> size of user-space write buffer
+        */
+        extract_writer(const std::filesystem::path& root, size_t buffer_size);
+        ~extract_writer();
+
+        extract_writer& operator=(const extract_writer&) = delete;
+        extract_writer& operator=(extract_writer&&)      = delete;
+
+    public:
+        bool is_valid() const;
+
+        /*
+            Close previous file, create missing parent directories and open file for writing.
+
+            @param file -> '/' separated path relative to root
+            @param size -> final file size
+
+            @returns bool -> true if file was opened
+        */
+        bool open(std::string_view file, uint64_t size);
+
+        /*
+            Write bytes to opened file.
+            Throws if writing fails.
+        */
+        void write(const uint8_t* src, size_t size);
+
+        /*
+            Open archive stored entries are copied from.
+
+            @param archive -> archive file
+
+            @returns bool -> true if copy() is supported
+        */
+        bool set_source(const std::filesystem::path& archive);
+
+        /*
+            Copy bytes from source archive to opened file without passing them through user space.
+            Throws if copying fails part way.
+
+            @param offset -> offset in source archive
+            @param size   -> number of bytes to copy
+
+            @returns bool -> false if nothing was copied because kernel copies aren't supported
+        */
+        bool copy(uint64_t offset, uint64_t size);
+
+        /*
+            Write out buffered bytes and close opened file.
+            Throws if writing fails.
+        */
+        void close();
+
+    private:
+        enum class copy_mode : uint8_t {
+            copy_file_range,
+            sendfile,
+            none
+        };
+
+    private:
+        std::filesystem::path           m_root;
+        std::unordered_set<std::string> m_created_dirs;
+        uint8_t*                        m_buffer      = nullptr;
+        size_t                          m_buffer_size = 0U;
+        size_t                          m_buffer_used = 0U;
+        uint64_t                        m_file_size   = 0U;
+        uint64_t                        m_written     = 0U;
+
+        // posix
+        std::string m_dir;
+        int         m_root_fd = -1;
+        int         m_dir_fd  = -1;
+        int         m_fd      = -1;
+        int         m_src_fd  = -1;
+        copy_mode   m_copy    = copy_mode::copy_file_range;
+
+        // fallback
+        std::unique_ptr<fstream_write> m_stream;
+
+    private:
+        bool create_directories(std::string_view dir);
+        void flush();
+        void write_out(const uint8_t* src, size_t size);
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+namespace libevp {
+    /*
+        Read-only memory mapped file.
+    */
+    class mapped_file {
+    public:
+        mapped_file()                   = delete;
+        mapped_file(const mapped_file&) = delete;
+        mapped_file(mapped_file&&)      = delete;
+
+        mapped_file(const std::filesystem::path& file);
+        ~mapped_file();
+
+        mapped_file& operator=(const mapped_file&) = delete;
+        mapped_file& operator=(mapped_file&&)      = delete;
+
+    public:
+        const uint8_t* data() const {
+            return m_data;
+        }
+
+        size_t size() const {
+            return m_size;
+        }
+
+        bool is_valid() const {
+            return m_data != nullptr;
+        }
+
+    private:
+        const uint8_t* m_data    = nullptr;
+        size_t         m_size    = 0U;
+        void*          m_handle  = nullptr;
+        void*          m_mapping = nullptr;
+    };
+}
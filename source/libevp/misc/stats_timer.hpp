@@ -0,0 +1,40 @@
+#pragma once
+
+#include "libevp/evp_stats.hpp"
+
+#include <chrono>
+
+namespace libevp {
+    /*
+        Adds time spent in scope to a stats phase.
+        Without a phase only measures elapsed time.
+        Does nothing if stats are not set.
+    */
+    class stats_timer {
+    public:
+        stats_timer(evp_stats* stats, evp_stats::phase phase = evp_stats::phase::count)
+            : m_stats(stats), m_phase(phase)
+        {
+            if (m_stats)
+                m_start = std::chrono::steady_clock::now();
+        }
+
+        ~stats_timer() {
+            if (m_stats && m_phase != evp_stats::phase::count)
+                m_stats->add_time(m_phase, elapsed());
+        }
+
+        stats_timer(const stats_timer&)            = delete;
+        stats_timer& operator=(const stats_timer&) = delete;
+
+    public:
+        std::chrono::nanoseconds elapsed() const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+        }
+
+    private:
+        evp_stats*                            m_stats;
+        evp_stats::phase                      m_phase;
+        std::chrono::steady_clock::time_point m_start = {};
+    };
+}
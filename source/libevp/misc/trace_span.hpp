@@ -0,0 +1,43 @@
+#pragma once
+
+#include "libevp/evp_trace.hpp"
+
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+namespace libevp {
+    /*
+        Records time spent in scope as a trace span.
+        Does nothing if trace is not set.
+    */
+    class trace_span {
+    public:
+        trace_span(evp_trace* trace, const char* name, const char* category,
+            uint64_t data_offset = UINT64_MAX, std::string_view file = {})
+            : m_trace(trace)
+        {
+            if (!m_trace) return;
+
+            m_span.name        = name;
+            m_span.category    = category;
+            m_span.data_offset = data_offset;
+            m_span.file        = file;
+            m_span.start       = evp_trace::clock_t::now();
+        }
+
+        ~trace_span() {
+            if (!m_trace) return;
+
+            m_span.end = evp_trace::clock_t::now();
+            m_trace->add_span(std::move(m_span));
+        }
+
+        trace_span(const trace_span&)            = delete;
+        trace_span& operator=(const trace_span&) = delete;
+
+    private:
+        evp_trace*      m_trace;
+        evp_trace::span m_span;
+    };
+}
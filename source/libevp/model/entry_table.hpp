@@ -0,0 +1,176 @@
+#pragma once
+
+#include "libevp/model/evp_fd.hpp"
+#include "libevp/model/evp_fd_view.hpp"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+namespace libevp {
+    /*
+        File fd table stored as structure of arrays.
+
+        All names live in one contiguous pool, numeric fields in separate arrays.
+        Entries are accessed through evp_fd_view, evp_fd is only built on request.
+    */
+    class entry_table {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = evp_fd_view;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = evp_fd_view;
+
+        public:
+            iterator(const entry_table* table, size_t index)
+                : m_table(table), m_index(index) {}
+
+        public:
+            evp_fd_view operator*() const {
+                return (*m_table)[m_index];
+            }
+
+            iterator& operator++() {
+                m_index++;
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator tmp = *this;
+                m_index++;
+                return tmp;
+            }
+
+            bool operator==(const iterator& other) const {
+                return m_index == other.m_index && m_table == other.m_table;
+            }
+
+            bool operator!=(const iterator& other) const {
+                return !(*this == other);
+            }
+
+        private:
+            const entry_table* m_table = nullptr;
+            size_t             m_index = 0U;
+        };
+
+    public:
+        entry_table() {
+            m_name_offsets.push_back(0U);
+        }
+
+    public:
+        size_t size() const {
+            return m_data_offsets.size();
+        }
+
+        bool empty() const {
+            return m_data_offsets.empty();
+        }
+
+        /*
+            Reserve space for entries and their names.
+        */
+        void reserve(size_t count, size_t names_size = 0U) {
+            m_name_offsets.reserve(count + 1);
+            m_data_offsets.reserve(count);
+            m_data_sizes.reserve(count);
+            m_data_compressed_sizes.reserve(count);
+            m_flags.reserve(count);
+            m_hashes.reserve(count);
+
+            if (names_size)
+                m_names.reserve(names_size);
+        }
+
+        void clear() {
+            m_names.clear();
+            m_name_offsets.assign(1, 0U);
+            m_data_offsets.clear();
+            m_data_sizes.clear();
+            m_data_compressed_sizes.clear();
+            m_flags.clear();
+            m_hashes.clear();
+        }
+
+        void push_back(const evp_fd_view& fd) {
+            m_names.append(fd.file);
+            m_name_offsets.push_back((uint32_t)m_names.size());
+            m_data_offsets.push_back(fd.data_offset);
+            m_data_sizes.push_back(fd.data_size);
+            m_data_compressed_sizes.push_back(fd.data_compressed_size);
+            m_flags.push_back(fd.flags);
+
+            auto& hash = m_hashes.emplace_back();
+            if (fd.hash)
+                memcpy(hash.data(), fd.hash, hash.size());
+        }
+
+        evp_fd_view operator[](size_t index) const {
+            evp_fd_view fd;
+            fd.file                 = file(index);
+            fd.data_offset          = m_data_offsets[index];
+            fd.data_size            = m_data_sizes[index];
+            fd.data_compressed_size = m_data_compressed_sizes[index];
+            fd.flags                = m_flags[index];
+            fd.hash                 = m_hashes[index].data();
+
+            return fd;
+        }
+
+        evp_fd_view at(size_t index) const {
+            if (index >= size())
+                throw std::out_of_range("Entry index out of bounds.");
+
+            return (*this)[index];
+        }
+
+        std::string_view file(size_t index) const {
+            uint32_t begin = m_name_offsets[index];
+            uint32_t end   = m_name_offsets[index + 1];
+
+            return std::string_view(m_names.data() + begin, end - begin);
+        }
+
+        uint64_t data_offset(size_t index) const {
+            return m_data_offsets[index];
+        }
+
+        uint64_t data_size(size_t index) const {
+            return m_data_sizes[index];
+        }
+
+        void set_data_offset(size_t index, uint64_t data_offset) {
+            m_data_offsets[index] = data_offset;
+        }
+
+        void set_hash(size_t index, const uint8_t* hash) {
+            memcpy(m_hashes[index].data(), hash, m_hashes[index].size());
+        }
+
+        iterator begin() const {
+            return iterator(this, 0U);
+        }
+
+        iterator end() const {
+            return iterator(this, size());
+        }
+
+    private:
+        std::string                          m_names                 = "";
+        std::vector<uint32_t>                m_name_offsets          = {};
+        std::vector<uint64_t>                m_data_offsets          = {};
+        std::vector<uint64_t>                m_data_sizes            = {};
+        std::vector<uint64_t>                m_data_compressed_sizes = {};
+        std::vector<uint32_t>                m_flags                 = {};
+        std::vector<std::array<uint8_t, 16>> m_hashes                = {};
+    };
+}
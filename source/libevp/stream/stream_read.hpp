@@ -1,6 +1,7 @@
 #pragma once
 
 #include "libevp/type_traits.hpp"
+#include "libevp/evp_source.hpp"
 
 #include <string>
 #include <cstring>
@@ -36,11 +37,11 @@ namespace libevp {
         fstream_read& operator=(fstream_read&&) = default;
 
     public:
-        size_t pos() const {
+        uint64_t pos() const {
             return m_pos;
         }
 
-        size_t size() const {
+        uint64_t size() const {
             return m_size;
         }
 
@@ -48,11 +49,11 @@ namespace libevp {
             return m_stream && m_stream->is_open();
         }
 
-        void seek(size_t offset, std::ios_base::seekdir dir = std::ios_base::cur) {
-            if (!m_stream->seekg(offset, dir))
+        void seek(uint64_t offset, std::ios_base::seekdir dir = std::ios_base::cur) {
+            if (!m_stream->seekg((std::streamoff)offset, dir))
                 throw std::out_of_range("Tried to seek outside file bounds.");
 
-            m_pos = static_cast<size_t>(m_stream->tellg());
+            m_pos = static_cast<uint64_t>(m_stream->tellg());
         }
 
         template<typename T>
@@ -75,8 +76,8 @@ namespace libevp {
 
     private:
         std::unique_ptr<std::ifstream> m_stream;
-        size_t                         m_size = 0U;
-        size_t                         m_pos  = 0U;
+        uint64_t                       m_size = 0U;
+        uint64_t                       m_pos  = 0U;
 
     private:
         void internal_read(void* dst, uint32_t size) {
@@ -86,7 +87,7 @@ namespace libevp {
             if (!m_stream->read((char*)dst, (size_t)size))
                 throw std::runtime_error("Failed to read requested size.");
 
-            m_pos = static_cast<size_t>(m_stream->tellg());
+            m_pos = static_cast<uint64_t>(m_stream->tellg());
         }
     };
 
@@ -154,4 +155,117 @@ namespace libevp {
             m_pos += size;
         }
     };
+
+    /*
+        Stream over an evp_source.
+    */
+    class source_read {
+    public:
+        source_read()                   = delete;
+        source_read(const source_read&) = delete;
+        source_read(source_read&&)      = default;
+
+        source_read(evp_source::ptr_t source)
+            : m_source(std::move(source))
+        {
+            if (!is_valid())
+                return;
+
+            m_data = m_source->data();
+            m_size = m_source->size();
+        }
+
+        source_read& operator=(const source_read&) = delete;
+        source_read& operator=(source_read&&)      = default;
+
+    public:
+        uint64_t pos() const {
+            return m_pos;
+        }
+
+        uint64_t size() const {
+            return m_size;
+        }
+
+        bool is_valid() const {
+            return m_source && m_source->is_valid();
+        }
+
+        /*
+            Get pointer to source contents, nullptr if not in memory.
+        */
+        const uint8_t* data() const {
+            return m_data;
+        }
+
+        void seek(uint64_t offset, std::ios_base::seekdir dir = std::ios_base::cur) {
+            uint64_t pos = m_pos;
+
+            if (dir == std::ios::cur)
+                pos += offset;
+            else if (dir == std::ios::beg)
+                pos = offset;
+            else if (dir == std::ios::end)
+                pos = m_size - offset;
+
+            if (pos > m_size)
+                throw std::out_of_range("Tried to seek outside bounds.");
+
+            m_pos = pos;
+        }
+
+        template<typename T>
+        requires arithmetic<T>
+        T read() {
+            T value{};
+            internal_read(&value, sizeof(T));
+            return value;
+        }
+
+        std::string read(uint32_t size) {
+            std::string value(size, 0);
+            internal_read(value.data(), size);
+            return value;
+        }
+
+        void read(uint8_t* dst, uint32_t size) {
+            internal_read(dst, size);
+        }
+
+        /*
+            Get pointer to the next size bytes and advance,
+            nullptr if source isn't in memory.
+        */
+        const uint8_t* view(uint32_t size) {
+            if (!m_data)
+                return nullptr;
+
+            if (m_pos + size > m_size)
+                throw std::out_of_range("Tried to read outside bounds.");
+
+            const uint8_t* data = m_data + m_pos;
+            m_pos += size;
+
+            return data;
+        }
+
+    private:
+        evp_source::ptr_t m_source;
+        const uint8_t*    m_data = nullptr;
+        uint64_t          m_size = 0U;
+        uint64_t          m_pos  = 0U;
+
+    private:
+        void internal_read(void* dst, uint32_t size) {
+            if (m_pos + size > m_size)
+                throw std::out_of_range("Tried to read outside bounds.");
+
+            if (m_data)
+                memcpy(dst, m_data + m_pos, size);
+            else
+                m_source->read(m_pos, (uint8_t*)dst, size);
+
+            m_pos += size;
+        }
+    };
 }
@@ -0,0 +1,146 @@
+#include "stream_write.hpp"
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+using namespace libevp;
+
+struct fstream_write::copy_files {
+    std::filesystem::path src_path;
+    int                   src = -1;
+    int                   dst = -1;
+};
+
+void fstream_write::copy_files_deleter::operator()(copy_files* files) const {
+#if defined(__linux__)
+    if (files->src != -1)
+        close(files->src);
+
+    if (files->dst != -1)
+        close(files->dst);
+#endif
+
+    delete files;
+}
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+
+bool fstream_write::preallocate(uint64_t size) {
+    if (!is_valid() || size == 0)
+        return false;
+
+    HANDLE handle = CreateFileW(m_path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    FILE_ALLOCATION_INFO info = {};
+    info.AllocationSize.QuadPart = (LONGLONG)size;
+
+    BOOL ok = SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info));
+
+    CloseHandle(handle);
+    return ok != FALSE;
+}
+
+bool fstream_write::copy_from(const std::filesystem::path& file, uint64_t offset, uint64_t size) {
+    return false;
+}
+
+#elif defined(__linux__)
+
+bool fstream_write::preallocate(uint64_t size) {
+    if (!is_valid() || size == 0)
+        return false;
+
+    int fd = open(m_path.c_str(), O_WRONLY);
+    if (fd == -1)
+        return false;
+
+    // keep size so the file doesn't end with preallocated zeroes
+    int ret = fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)size);
+
+    close(fd);
+    return ret == 0;
+}
+
+bool fstream_write::copy_from(const std::filesystem::path& file, uint64_t offset, uint64_t size) {
+    if (!is_valid())
+        return false;
+
+    // bytes written so far have to be in the file before copying after them
+    flush();
+
+    if (!m_stream->flush())
+        throw std::runtime_error("Failed to write requested size.");
+
+    // callers copy in chunks, keep both files open between calls
+    if (!m_copy_files)
+        m_copy_files.reset(new copy_files());
+
+    copy_files& files = *m_copy_files;
+
+    if (files.dst == -1) {
+        files.dst = open(m_path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (files.dst == -1)
+            return false;
+    }
+
+    if (files.src == -1 || files.src_path != file) {
+        if (files.src != -1)
+            close(files.src);
+
+        files.src      = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        files.src_path = file;
+
+        if (files.src == -1)
+            return false;
+    }
+
+    loff_t   src_offset = (loff_t)offset;
+    loff_t   dst_offset = (loff_t)m_pos;
+    uint64_t left       = size;
+
+    while (left != 0U) {
+        ssize_t ret = copy_file_range(files.src, &src_offset, files.dst, &dst_offset, (size_t)left, 0);
+
+        if (ret == -1 && errno == EINTR)
+            continue;
+
+        if (ret <= 0)
+            break;
+
+        left -= (uint64_t)ret;
+    }
+
+    if (left == size)
+        return false;
+
+    if (left != 0U)
+        throw std::runtime_error("Failed to write requested size.");
+
+    m_pos += size;
+    m_stream->seekp((std::streamoff)m_pos, std::ios::beg);
+
+    return true;
+}
+
+#else
+
+bool fstream_write::preallocate(uint64_t size) {
+    return false;
+}
+
+bool fstream_write::copy_from(const std::filesystem::path& file, uint64_t offset, uint64_t size) {
+    return false;
+}
+
+#endif
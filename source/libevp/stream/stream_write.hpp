@@ -1,11 +1,16 @@
 #pragma once
 
 #include "libevp/type_traits.hpp"
+#include "libevp/evp_sink.hpp"
 
 #include <string>
+#include <string_view>
+#include <cstring>
 #include <memory>
+#include <vector>
 #include <fstream>
 #include <filesystem>
+#include <stdexcept>
 
 namespace libevp {
     class fstream_write {
@@ -14,56 +19,314 @@ namespace libevp {
         fstream_write(const fstream_write&) = delete;
         fstream_write(fstream_write&&)      = default;
 
-        fstream_write(const std::filesystem::path& file) {
+        /*
+            @param file        -> file to write to
+            @param buffer_size -> size of user-space write buffer, 0 writes straight to the stream
+        */
+        fstream_write(const std::filesystem::path& file, size_t buffer_size = 0U)
+            : m_path(file)
+        {
             m_stream = std::make_unique<std::ofstream>(file, std::ios::binary);
             if (!m_stream || !m_stream->is_open()) {
                 m_stream = nullptr;
                 return;
             }
+
+            m_buffer.reserve(buffer_size);
+        }
+
+        ~fstream_write() {
+            if (!m_stream || m_buffer.empty())
+                return;
+
+            // errors can't be reported here, call flush() to check them
+            m_stream->write((const char*)m_buffer.data(), (std::streamsize)m_buffer.size());
         }
 
         fstream_write& operator=(const fstream_write&) = delete;
         fstream_write& operator=(fstream_write&&)      = default;
 
     public:
-        size_t pos() const {
-            return (size_t)m_stream->tellp();
+        uint64_t pos() const {
+            return m_pos;
         }
 
         bool is_valid() const {
             return m_stream && m_stream->is_open();
         }
 
-        void seek(size_t offset, std::ios_base::seekdir dir = std::ios_base::cur) {
-            m_stream->seekp(offset, dir);
+        void seek(uint64_t offset, std::ios_base::seekdir dir = std::ios_base::cur) {
+            flush();
+
+            m_stream->seekp((std::streamoff)offset, dir);
+            m_pos = (uint64_t)m_stream->tellp();
+        }
+
+        /*
+            Write buffered data to the stream.
+        */
+        void flush() {
+            if (m_buffer.empty())
+                return;
+
+            m_stream->write((const char*)m_buffer.data(), (std::streamsize)m_buffer.size());
+            m_buffer.clear();
+
+            if (!(*m_stream))
+                throw std::runtime_error("Failed to write requested size.");
         }
 
+        /*
+            Reserve disk space for the file without changing its size.
+            Best effort, does nothing where not supported.
+
+            @param size -> expected final file size
+
+            @returns bool -> true if space was reserved
+        */
+        bool preallocate(uint64_t size);
+
+        /*
+            Append part of another file inside the kernel.
+            Throws if copying fails part way.
+
+            @param file   -> file to copy from
+            @param offset -> offset in file
+            @param size   -> number of bytes to copy
+
+            @returns bool -> false if not supported and nothing was written
+        */
+        bool copy_from(const std::filesystem::path& file, uint64_t offset, uint64_t size);
+
         template<typename T>
         requires arithmetic<T> || is_enum<T>
         void write(const T value) {
             internal_write(&value, sizeof(T));
         }
 
-        void write(const std::string& str) {
+        void write(std::string_view str) {
             uint32_t size = (uint32_t)str.size();
 
             write(size);
             internal_write(str.data(), size);
         }
 
-        void write(uint8_t* src, uint32_t size) {
+        void write(const uint8_t* src, size_t size) {
             internal_write(src, size);
         }
 
     private:
-        std::unique_ptr<std::ofstream> m_stream;
+        /*
+            Files kept open between copy_from calls.
+        */
+        struct copy_files;
+
+        struct copy_files_deleter {
+            void operator()(copy_files* files) const;
+        };
 
     private:
-        void internal_write(const void* src, uint32_t size) {
-            m_stream->write((const char*)src, (size_t)size);
+        std::unique_ptr<std::ofstream>                  m_stream;
+        std::filesystem::path                           m_path;
+        std::vector<uint8_t>                            m_buffer;
+        uint64_t                                        m_pos = 0U;
+        std::unique_ptr<copy_files, copy_files_deleter> m_copy_files;
 
-            if (!(*m_stream))
-                throw std::runtime_error("Failed to write requested size.");
+    private:
+        void internal_write(const void* src, size_t size) {
+            m_pos += size;
+
+            if (m_buffer.size() + size <= m_buffer.capacity()) {
+                m_buffer.insert(m_buffer.end(), (const uint8_t*)src, (const uint8_t*)src + size);
+                return;
+            }
+
+            flush();
+
+            // writes larger than the buffer skip it
+            if (size >= m_buffer.capacity()) {
+                m_stream->write((const char*)src, (std::streamsize)size);
+
+                if (!(*m_stream))
+                    throw std::runtime_error("Failed to write requested size.");
+
+                return;
+            }
+
+            m_buffer.insert(m_buffer.end(), (const uint8_t*)src, (const uint8_t*)src + size);
+        }
+    };
+
+    class stream_write {
+    public:
+        stream_write()                    = delete;
+        stream_write(const stream_write&) = delete;
+        stream_write(stream_write&&)      = default;
+
+        stream_write(std::vector<uint8_t>& buffer)
+            : m_buffer(buffer) {}
+
+        stream_write& operator=(const stream_write&) = delete;
+        stream_write& operator=(stream_write&&)      = default;
+
+    public:
+        size_t pos() const {
+            return m_buffer.size();
+        }
+
+        template<typename T>
+        requires arithmetic<T> || is_enum<T>
+        void write(const T value) {
+            internal_write(&value, sizeof(T));
+        }
+
+        void write(std::string_view str) {
+            uint32_t size = (uint32_t)str.size();
+
+            write(size);
+            internal_write(str.data(), size);
+        }
+
+        void write(const uint8_t* src, size_t size) {
+            internal_write(src, size);
+        }
+
+    private:
+        std::vector<uint8_t>& m_buffer;
+
+    private:
+        void internal_write(const void* src, size_t size) {
+            size_t pos = m_buffer.size();
+
+            m_buffer.resize(pos + size);
+            memcpy(m_buffer.data() + pos, src, size);
+        }
+    };
+
+    /*
+        Buffered stream over an evp_sink.
+    */
+    class sink_write {
+    public:
+        sink_write()                  = delete;
+        sink_write(const sink_write&) = delete;
+        sink_write(sink_write&&)      = default;
+
+        /*
+            @param sink        -> sink to write to
+            @param buffer_size -> size of user-space write buffer, 0 writes straight to the sink
+        */
+        sink_write(evp_sink::ptr_t sink, size_t buffer_size = 0U)
+            : m_sink(std::move(sink))
+        {
+            if (!is_valid())
+                return;
+
+            m_pos = m_sink->pos();
+            m_buffer.reserve(buffer_size);
+        }
+
+        sink_write& operator=(const sink_write&) = delete;
+        sink_write& operator=(sink_write&&)      = default;
+
+    public:
+        uint64_t pos() const {
+            return m_pos;
+        }
+
+        bool is_valid() const {
+            return m_sink && m_sink->is_valid();
+        }
+
+        bool is_seekable() const {
+            return m_sink->is_seekable();
+        }
+
+        void seek(uint64_t offset, std::ios_base::seekdir dir = std::ios_base::cur) {
+            if (dir == std::ios::cur)
+                offset += m_pos;
+            else if (dir != std::ios::beg)
+                throw std::invalid_argument("Unsupported seek direction.");
+
+            if (offset == m_pos)
+                return;
+
+            flush();
+
+            m_sink->seek(offset);
+            m_pos = offset;
+        }
+
+        /*
+            Write buffered data to the sink and flush it.
+        */
+        void flush() {
+            flush_buffer();
+            m_sink->flush();
+        }
+
+        bool preallocate(uint64_t size) {
+            return m_sink->preallocate(size);
+        }
+
+        bool copy_from(const std::filesystem::path& file, uint64_t offset, uint64_t size) {
+            flush_buffer();
+
+            if (!m_sink->copy_from(file, offset, size))
+                return false;
+
+            m_pos += size;
+            return true;
+        }
+
+        template<typename T>
+        requires arithmetic<T> || is_enum<T>
+        void write(const T value) {
+            internal_write(&value, sizeof(T));
+        }
+
+        void write(std::string_view str) {
+            uint32_t size = (uint32_t)str.size();
+
+            write(size);
+            internal_write(str.data(), size);
+        }
+
+        void write(const uint8_t* src, size_t size) {
+            internal_write(src, size);
+        }
+
+    private:
+        evp_sink::ptr_t      m_sink;
+        std::vector<uint8_t> m_buffer;
+        uint64_t             m_pos = 0U;
+
+    private:
+        void flush_buffer() {
+            if (m_buffer.empty())
+                return;
+
+            m_sink->write(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+        }
+
+        void internal_write(const void* src, size_t size) {
+            m_pos += size;
+
+            if (m_buffer.size() + size <= m_buffer.capacity()) {
+                m_buffer.insert(m_buffer.end(), (const uint8_t*)src, (const uint8_t*)src + size);
+                return;
+            }
+
+            flush_buffer();
+
+            // writes larger than the buffer skip it
+            if (size >= m_buffer.capacity()) {
+                m_sink->write((const uint8_t*)src, size);
+                return;
+            }
+
+            m_buffer.insert(m_buffer.end(), (const uint8_t*)src, (const uint8_t*)src + size);
         }
     };
 }
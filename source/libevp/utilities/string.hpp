@@ -3,4 +3,24 @@
 #define FMT_HEADER_ONLY
 #include <fmt/format.h>
 
-#define EVP_STR_FORMAT(frmt, ...) fmt::format(fmt::runtime(frmt), ##__VA_ARGS__)
\ No newline at end of file
+#include <string>
+#include <algorithm>
+#include <filesystem>
+
+#define EVP_STR_FORMAT(frmt, ...) fmt::format(fmt::runtime(frmt), ##__VA_ARGS__)
+
+namespace libevp {
+    /*
+        Convert file path to the form used by fds read from archives.
+    */
+    inline std::string to_fd_name(const std::filesystem::path& file) {
+        std::string name = file.string();
+
+        std::replace(name.begin(), name.end(), '\\', '/');
+
+        if (!name.empty() && name[0] == '/')
+            name.erase(0, 1);
+
+        return name;
+    }
+}
@@ -0,0 +1,162 @@
+#include <libevp.hpp>
+#include <libevp/evp_coro.hpp>
+#include <gtest/gtest.h>
+
+#include <future>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+using namespace libevp;
+
+/*
+    Minimal eagerly started coroutine for tests.
+*/
+struct test_task {
+    struct promise_type {
+        test_task           get_return_object()        { return {}; }
+        std::suspend_never  initial_suspend() noexcept { return {}; }
+        std::suspend_never  final_suspend() noexcept   { return {}; }
+        void                return_void()              {}
+        void                unhandled_exception()      { std::terminate(); }
+    };
+};
+
+/*
+    Single thread event loop used as a cross-thread executor.
+*/
+class test_loop {
+public:
+    test_loop() : m_thread([this] { run(); }) {}
+
+    ~test_loop() {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_stop = true;
+        }
+
+        m_cv.notify_one();
+        m_thread.join();
+    }
+
+public:
+    void post(std::function<void()> fn) {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_queue.push_back(std::move(fn));
+        }
+
+        m_cv.notify_one();
+    }
+
+    std::thread::id get_id() const {
+        return m_thread.get_id();
+    }
+
+private:
+    std::mutex                        m_mutex;
+    std::condition_variable           m_cv;
+    std::deque<std::function<void()>> m_queue;
+    bool                              m_stop = false;
+    std::thread                       m_thread;
+
+private:
+    void run() {
+        while (true) {
+            std::function<void()> fn;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+
+                if (m_queue.empty())
+                    return;
+
+                fn = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            fn();
+        }
+    }
+};
+
+static test_task get_files_task(evp_coro& coro, std::string input, std::promise<bool>& done) {
+    evp_index idx;
+
+    auto r1 = co_await coro.open(input, idx, input + ".coro.idx");
+    if (!r1) {
+        done.set_value(false);
+        co_return;
+    }
+
+    std::vector<evp_fd> files = {};
+    for (size_t i = 0; i < idx.size(); i++) {
+        idx.get_fd(i, files.emplace_back());
+    }
+
+    idx.close();
+    std::remove((input + ".coro.idx").c_str());
+
+    std::vector<evp_cache::buffer_ptr_t> buffers = {};
+
+    auto r2 = co_await coro.get_files(input, files, buffers);
+    auto r3 = co_await coro.validate_files(input);
+
+    done.set_value(r2 && r3 && buffers.size() == 4 && buffers[3]->size() == files[3].data_size);
+}
+
+TEST(coro, get_files) {
+    evp evp;
+    evp.set_thread_pool(std::make_shared<evp_thread_pool>(1));
+
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    evp_coro coro(evp);
+
+    std::promise<bool> done;
+    auto future = done.get_future();
+
+    get_files_task(coro, input, done);
+
+    ASSERT_TRUE(future.get());
+}
+
+static test_task loop_task(evp_coro& coro, std::string input, std::thread::id loop_id, std::promise<bool>& done) {
+    bool ok = true;
+
+    // each resume runs on the loop and the frame is destroyed there,
+    // possibly while the worker is still returning from the executor
+    for (size_t i = 0; i < 64; i++) {
+        std::vector<evp_fd> failed = {};
+
+        auto result = co_await coro.validate_files(input, &failed);
+        ok = ok && result && failed.empty() && std::this_thread::get_id() == loop_id;
+    }
+
+    done.set_value(ok);
+}
+
+TEST(coro, cross_thread_executor) {
+    evp evp;
+    evp.set_thread_pool(std::make_shared<evp_thread_pool>(2));
+
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    test_loop loop;
+    evp_coro  coro(evp, [&loop](std::function<void()> fn) { loop.post(std::move(fn)); });
+
+    std::promise<bool> done;
+    auto future = done.get_future();
+
+    loop.post([&] { loop_task(coro, input, loop.get_id(), done); });
+
+    ASSERT_TRUE(future.get());
+
+    // workers may still be returning from the executor
+    evp.get_thread_pool()->wait_idle();
+}
@@ -1,8 +1,60 @@
 #include <libevp.hpp>
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <future>
+#include <chrono>
+#include <filesystem>
+
+#if defined(__linux__)
+    #include <sys/stat.h>
+#endif
+
 using namespace libevp;
 
+/*
+    Removes a file when leaving scope, also when an assertion fails.
+*/
+struct remove_guard {
+    std::filesystem::path path;
+
+    ~remove_guard() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+};
+
+/*
+    Check if files in dir keep gaps written by seeking past the end unallocated.
+*/
+static bool supports_sparse_files(const std::filesystem::path& dir) {
+#if defined(__linux__)
+    constexpr uint64_t PROBE_SIZE = 64U * 1024U * 1024U;
+
+    remove_guard probe{ dir / "libevp_sparse_probe" };
+
+    {
+        std::ofstream stream(probe.path, std::ios::binary | std::ios::trunc);
+        stream.seekp(PROBE_SIZE);
+        stream.put(0);
+
+        if (!stream)
+            return false;
+    }
+
+    struct stat st = {};
+    if (stat(probe.path.c_str(), &st) != 0)
+        return false;
+
+    return (uint64_t)st.st_blocks * 512U < PROBE_SIZE;
+#else
+    // not sparse unless explicitly marked so, e.g. on NTFS
+    return false;
+#endif
+}
+
 TEST(misc, get_archive_fds) {
     evp         evp;
     std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
@@ -25,3 +77,488 @@ TEST(misc, validate_files) {
     auto result = evp.validate_files(input);
     ASSERT_TRUE(result);
 }
+
+TEST(misc, thread_pool_io_limit) {
+    uint32_t limit = evp_thread_pool::get_io_limit();
+    evp_thread_pool::set_io_limit(1U);
+
+    {
+        evp_thread_pool pool(2);
+
+        std::promise<void>       plain_done;
+        std::shared_future<void> plain_ran = plain_done.get_future().share();
+        std::promise<void>       io_done[2];
+
+        // queued I/O tasks over the limit must not keep plain tasks from running
+        for (auto& done : io_done) {
+            pool.post_io([plain_ran, &done] {
+                plain_ran.wait();
+                done.set_value();
+            });
+        }
+
+        pool.post([&plain_done] { plain_done.set_value(); });
+
+        for (auto& done : io_done) {
+            EXPECT_TRUE(done.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        }
+
+        pool.wait_idle();
+    }
+
+    evp_thread_pool::set_io_limit(limit);
+}
+
+TEST(misc, index_sidecar) {
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+    std::string index = BASE_PATH + std::string("/tests/v1/resources/multiple_files_test.evp.idx");
+
+    evp_index idx;
+    EXPECT_FALSE(idx.load(input, index));
+    ASSERT_TRUE(idx.open(input, index));
+    ASSERT_TRUE(idx.size() == 4);
+
+    evp_fd fd;
+    ASSERT_TRUE(idx.find("subfolder_2/text_3.txt", fd));
+    EXPECT_TRUE(fd.file == "subfolder_2/text_3.txt");
+    EXPECT_FALSE(idx.find("missing.txt", fd));
+
+    std::vector<evp_fd> files = {};
+    evp evp;
+    ASSERT_TRUE(evp.get_archive_fds(input, files));
+
+    for (size_t i = 0; i < files.size(); i++) {
+        idx.get_fd(i, fd);
+        EXPECT_TRUE(fd.file == files[i].file);
+        EXPECT_TRUE(fd.data_offset == files[i].data_offset);
+        EXPECT_TRUE(fd.hash == files[i].hash);
+    }
+
+    idx.close();
+
+    // corrupt first record's name offset, header and stamp stay valid
+    {
+        std::fstream stream(index, std::ios::binary | std::ios::in | std::ios::out);
+
+        uint32_t records_offset = 0U;
+        stream.seekg(124);
+        stream.read((char*)&records_offset, sizeof(records_offset));
+
+        uint32_t name_offset = 0xFFFFFF00U;
+        stream.seekp(records_offset);
+        stream.write((const char*)&name_offset, sizeof(name_offset));
+    }
+
+    EXPECT_FALSE(idx.load(input, index));
+    ASSERT_TRUE(idx.open(input, index));
+    EXPECT_TRUE(idx.find("subfolder_2/text_3.txt", fd));
+
+    idx.close();
+
+    // swap first two entries of the sorted order
+    {
+        std::fstream stream(index, std::ios::binary | std::ios::in | std::ios::out);
+
+        uint32_t sorted_offset = 0U;
+        stream.seekg(140);
+        stream.read((char*)&sorted_offset, sizeof(sorted_offset));
+
+        uint32_t sorted[2] = {};
+        stream.seekg(sorted_offset);
+        stream.read((char*)sorted, sizeof(sorted));
+
+        std::swap(sorted[0], sorted[1]);
+        stream.seekp(sorted_offset);
+        stream.write((const char*)sorted, sizeof(sorted));
+    }
+
+    EXPECT_FALSE(idx.load(input, index));
+    ASSERT_TRUE(idx.open(input, index));
+    EXPECT_TRUE(idx.find_prefix("subfolder_1/").size() == 2);
+
+    idx.close();
+    std::remove(index.c_str());
+}
+
+TEST(misc, index_queries) {
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+    std::string index = BASE_PATH + std::string("/tests/v1/resources/multiple_files_queries.evp.idx");
+
+    evp_index idx;
+    ASSERT_TRUE(idx.open(input, index));
+
+    auto prefixed = idx.find_prefix("subfolder_1/");
+    ASSERT_TRUE(prefixed.size() == 2);
+    EXPECT_TRUE(prefixed[0].file == "subfolder_1/text_1.txt");
+    EXPECT_TRUE(prefixed[1].file == "subfolder_1/text_2.txt");
+
+    std::vector<evp_fd_view>      files = {};
+    std::vector<std::string_view> dirs  = {};
+    idx.list_dir("", files, &dirs);
+
+    ASSERT_TRUE(files.size() == 1);
+    EXPECT_TRUE(files[0].file == "text_1.txt");
+    ASSERT_TRUE(dirs.size() == 2);
+    EXPECT_TRUE(dirs[0] == "subfolder_1");
+    EXPECT_TRUE(dirs[1] == "subfolder_2");
+
+    EXPECT_TRUE(idx.glob("*/text_?.txt").size() == 3);
+    EXPECT_TRUE(idx.glob("**.txt").size() == 4);
+    EXPECT_TRUE(idx.glob("**/text_1.txt").size() == 2);
+    EXPECT_TRUE(idx.glob("subfolder_2/*").size() == 1);
+    EXPECT_TRUE(idx.glob("*.txt").size() == 1);
+
+    idx.close();
+    std::remove(index.c_str());
+}
+
+TEST(misc, wide_container) {
+    std::string input  = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+    std::string output = BASE_PATH + std::string("/tests/v1/resources/multiple_files_wide.evp");
+    std::string index  = BASE_PATH + std::string("/tests/v1/resources/multiple_files_wide.evp.idx");
+
+    evp evp;
+
+    std::vector<evp_fd> files = {};
+    ASSERT_TRUE(evp.get_archive_fds(input, files));
+
+    // rewrite archive in the 64-bit container layout
+    {
+        std::ifstream in(input, std::ios::binary);
+        std::ofstream out(output, std::ios::binary | std::ios::trunc);
+
+        char magic[56] = {};
+        in.read(magic, sizeof(magic));
+
+        auto write_u32 = [&](uint32_t value) { out.write((const char*)&value, sizeof(value)); };
+        auto write_u64 = [&](uint64_t value) { out.write((const char*)&value, sizeof(value)); };
+
+        uint64_t              offset  = 84U;
+        std::vector<uint64_t> offsets = {};
+
+        out.write(magic, sizeof(magic));
+        write_u32(0x00010064);
+        write_u64(0U);
+        write_u64(0U);
+        write_u32((uint32_t)files.size());
+        write_u32(0U);
+
+        for (const evp_fd& fd : files) {
+            std::vector<uint8_t> buffer;
+            ASSERT_TRUE(evp.get_file(input, fd, buffer));
+
+            out.write((const char*)buffer.data(), buffer.size());
+            offsets.push_back(offset);
+            offset += buffer.size();
+        }
+
+        uint64_t desc_offset = offset;
+
+        write_u32(0U);
+        write_u32(0U);
+        write_u32(0U);
+        write_u32(0U);
+
+        for (size_t i = 0; i < files.size(); i++) {
+            write_u32((uint32_t)files[i].file.size());
+            out.write(files[i].file.data(), files[i].file.size());
+            write_u64(offsets[i]);
+            write_u64(files[i].data_size);
+            write_u64(files[i].data_size);
+            write_u32(0x1);
+            write_u64(0U);
+            out.write((const char*)files[i].hash.data(), files[i].hash.size());
+        }
+
+        uint64_t desc_size = (uint64_t)out.tellp() - desc_offset;
+
+        out.seekp(60, std::ios::beg);
+        write_u64(desc_offset);
+        write_u64(desc_size);
+    }
+
+    std::vector<evp_fd> wide_files = {};
+    ASSERT_TRUE(evp.get_archive_fds(output, wide_files));
+    ASSERT_TRUE(wide_files.size() == files.size());
+    EXPECT_TRUE(wide_files[0].data_offset == 84U);
+
+    for (size_t i = 0; i < files.size(); i++) {
+        std::vector<uint8_t> expected, actual;
+        ASSERT_TRUE(evp.get_file(input, files[i], expected));
+        ASSERT_TRUE(evp.get_file(output, wide_files[i], actual));
+
+        EXPECT_TRUE(wide_files[i].file == files[i].file);
+        EXPECT_TRUE(actual == expected);
+    }
+
+    EXPECT_TRUE(evp.validate_files(output));
+
+    evp_index idx;
+    ASSERT_TRUE(idx.open(output, index));
+    ASSERT_TRUE(idx.size() == files.size());
+
+    evp_fd fd;
+    ASSERT_TRUE(idx.find("text_1.txt", fd));
+    EXPECT_TRUE(fd.data_offset == wide_files[3].data_offset);
+
+    idx.close();
+    std::remove(index.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(misc, wide_container_sparse) {
+    std::filesystem::path temp = std::filesystem::temp_directory_path();
+
+    if (!supports_sparse_files(temp))
+        GTEST_SKIP() << "Sparse files not supported in " << temp.string();
+
+    std::string  input  = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+    remove_guard output{ temp / "libevp_multiple_files_sparse.evp" };
+
+    constexpr uint64_t DATA_OFFSET = 5ULL * 1024U * 1024U * 1024U;
+
+    evp evp;
+
+    std::vector<evp_fd> files = {};
+    ASSERT_TRUE(evp.get_archive_fds(input, files));
+
+    // write 64-bit container with entry data past 4 GiB, the gap stays sparse
+    {
+        auto sink = evp_sink::from_file(output.path);
+        ASSERT_TRUE(sink->is_valid());
+
+        auto write = [&](const auto value) { sink->write((const uint8_t*)&value, sizeof(value)); };
+
+        uint8_t magic[56] = {};
+        std::ifstream(input, std::ios::binary).read((char*)magic, sizeof(magic));
+
+        sink->write(magic, sizeof(magic));
+        write(0x00010064U);
+        write(uint64_t(0U));
+        write(uint64_t(0U));
+        write((uint32_t)files.size());
+        write(0U);
+
+        sink->seek(DATA_OFFSET);
+
+        std::vector<uint64_t> offsets = {};
+
+        for (const evp_fd& fd : files) {
+            std::vector<uint8_t> buffer;
+            ASSERT_TRUE(evp.get_file(input, fd, buffer));
+
+            offsets.push_back(sink->pos());
+            sink->write(buffer.data(), buffer.size());
+        }
+
+        uint64_t desc_offset = sink->pos();
+        ASSERT_TRUE(desc_offset > DATA_OFFSET);
+
+        for (uint32_t i = 0; i < 4; i++) {
+            write(0U);
+        }
+
+        for (size_t i = 0; i < files.size(); i++) {
+            write((uint32_t)files[i].file.size());
+            sink->write((const uint8_t*)files[i].file.data(), files[i].file.size());
+            write(offsets[i]);
+            write(files[i].data_size);
+            write(files[i].data_size);
+            write(0x1U);
+            write(uint64_t(0U));
+            sink->write(files[i].hash.data(), files[i].hash.size());
+        }
+
+        uint64_t desc_size = sink->pos() - desc_offset;
+
+        sink->seek(60U);
+        write(desc_offset);
+        write(desc_size);
+        sink->flush();
+    }
+
+    std::vector<evp_fd> wide_files = {};
+    ASSERT_TRUE(evp.get_archive_fds(output.path, wide_files));
+    ASSERT_TRUE(wide_files.size() == files.size());
+    EXPECT_TRUE(wide_files[0].data_offset == DATA_OFFSET);
+
+    for (size_t i = 0; i < files.size(); i++) {
+        std::vector<uint8_t> expected, actual;
+        ASSERT_TRUE(evp.get_file(input, files[i], expected));
+        ASSERT_TRUE(evp.get_file(output.path, wide_files[i], actual));
+
+        EXPECT_TRUE(actual == expected);
+    }
+
+    EXPECT_TRUE(evp.validate_files(output.path));
+}
+
+TEST(misc, memory_source) {
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    std::ifstream        stream(input, std::ios::binary);
+    std::vector<uint8_t> archive((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    evp evp;
+
+    std::vector<evp_fd> files = {};
+    ASSERT_TRUE(evp.get_archive_fds(input, files));
+
+    auto memory = evp_source::from_memory(archive.data(), archive.size());
+
+    std::vector<evp_fd> memory_files = {};
+    ASSERT_TRUE(evp.get_archive_fds(memory, memory_files));
+    ASSERT_TRUE(memory_files.size() == files.size());
+    EXPECT_TRUE(evp.validate_files(memory));
+
+    std::vector<uint8_t> expected, actual;
+    ASSERT_TRUE(evp.get_file(input, files[2], expected));
+    ASSERT_TRUE(evp.get_file(memory, FILE_PATH("subfolder_2/text_3.txt"), actual));
+    EXPECT_TRUE(actual == expected);
+
+    auto callback = evp_source::from_callback(archive.size(), [&](uint64_t offset, uint8_t* dst, size_t size) {
+        memcpy(dst, archive.data() + offset, size);
+        return true;
+    });
+
+    ASSERT_TRUE(evp.get_file(callback, files[2], actual));
+    EXPECT_TRUE(actual == expected);
+    EXPECT_TRUE(evp.validate_files(callback));
+
+    // desc block size past the end of the archive
+    uint32_t desc_size = 0xFFFFFF00U;
+    memcpy(archive.data() + 64, &desc_size, sizeof(desc_size));
+
+    memory_files.clear();
+    EXPECT_FALSE(evp.get_archive_fds(memory, memory_files));
+}
+
+TEST(misc, transcode) {
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    std::ifstream        stream(input, std::ios::binary);
+    std::vector<uint8_t> expected((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    evp evp;
+
+    evp::transcode_input transcode_input;
+    transcode_input.archive          = evp_source::from_file(input);
+    transcode_input.recompute_hashes = true;
+
+    std::vector<uint8_t> output;
+    ASSERT_TRUE(evp.transcode(transcode_input, evp_sink::from_memory(output)));
+
+    // header desc block size differs, fixture excludes the block's leading fields
+    ASSERT_TRUE(output.size() == expected.size());
+    EXPECT_TRUE(std::equal(output.begin() + 76, output.end(), expected.begin() + 76));
+    EXPECT_TRUE(evp.validate_files(evp_source::from_memory(output.data(), output.size())));
+}
+
+TEST(misc, validate_tiers) {
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    std::ifstream        stream(input, std::ios::binary);
+    std::vector<uint8_t> archive((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    evp evp;
+
+    std::vector<evp_fd> files = {};
+    ASSERT_TRUE(evp.get_archive_fds(input, files));
+
+    evp::validate_input options;
+    options.sample_count = 1U;
+
+    for (auto tier : { evp::validate_tier::structural, evp::validate_tier::quick, evp::validate_tier::full }) {
+        options.tier = tier;
+        EXPECT_TRUE(evp.validate(input, options));
+    }
+
+    // corrupt data passes structural checks only
+    std::vector<uint8_t> corrupt = archive;
+    corrupt[files[0].data_offset] ^= 0xFF;
+
+    auto corrupt_source = evp_source::from_memory(corrupt.data(), corrupt.size());
+
+    std::vector<evp::validate_issue> issues;
+
+    options.tier = evp::validate_tier::structural;
+    EXPECT_TRUE(evp.validate(corrupt_source, options, &issues));
+    EXPECT_TRUE(issues.empty());
+
+    options.tier = evp::validate_tier::quick;
+    EXPECT_FALSE(evp.validate(corrupt_source, options, &issues));
+    ASSERT_TRUE(issues.size() == 1);
+    EXPECT_TRUE(issues[0].kind == evp::validate_issue::type::hash_mismatch);
+    EXPECT_TRUE(issues[0].fd.file == files[0].file);
+
+    // data offset, compressed size and size are stored right after entry name in the descriptor
+    uint32_t desc_offset = 0U;
+    memcpy(&desc_offset, archive.data() + 60, sizeof(desc_offset));
+
+    auto get_field = [&](const evp_fd& fd) {
+        std::string name = fd.file;
+        std::replace(name.begin(), name.end(), '/', '\\');
+
+        auto it = std::search(archive.begin() + desc_offset, archive.end(), name.begin(), name.end());
+        return it == archive.end() ? 0U : (size_t)(it - archive.begin()) + name.size();
+    };
+
+    size_t field = get_field(files[1]);
+    ASSERT_TRUE(field != 0U);
+
+    for (auto [offset, kind] : { std::pair{ (uint32_t)files[0].data_offset + 1U, evp::validate_issue::type::overlap },
+                                 std::pair{ (uint32_t)archive.size(), evp::validate_issue::type::out_of_bounds },
+                                 std::pair{ 0U, evp::validate_issue::type::out_of_bounds } })
+    {
+        std::vector<uint8_t> broken = archive;
+        memcpy(broken.data() + field, &offset, sizeof(offset));
+
+        auto broken_source = evp_source::from_memory(broken.data(), broken.size());
+
+        // quick tier stops at the structural one
+        options.tier = evp::validate_tier::quick;
+        issues.clear();
+
+        EXPECT_FALSE(evp.validate(broken_source, options, &issues));
+        ASSERT_TRUE(issues.size() == 1);
+        EXPECT_TRUE(issues[0].kind == kind);
+        EXPECT_TRUE(issues[0].fd.file == files[1].file);
+
+        // full tier hashes the rest, the moved entry is reported once
+        options.tier = evp::validate_tier::full;
+        issues.clear();
+
+        EXPECT_FALSE(evp.validate(broken_source, options, &issues));
+        ASSERT_TRUE(!issues.empty());
+        EXPECT_TRUE(issues[0].kind == kind);
+        EXPECT_TRUE(std::all_of(issues.begin(), issues.end(), [&](const auto& issue) { return issue.fd.file == files[1].file; }));
+
+        std::vector<evp_fd> failed = {};
+
+        EXPECT_FALSE(evp.validate_files(broken_source, &failed));
+        ASSERT_TRUE(failed.size() == 1);
+        EXPECT_TRUE(failed[0].file == files[1].file);
+    }
+
+    // two identical ranges inside the first entry's range
+    {
+        std::vector<uint8_t> broken = archive;
+
+        uint32_t range[3] = { (uint32_t)files[0].data_offset + 1U, 1U, 1U };
+
+        for (size_t i : { 1U, 2U }) {
+            size_t entry_field = get_field(files[i]);
+            ASSERT_TRUE(entry_field != 0U);
+
+            memcpy(broken.data() + entry_field, range, sizeof(range));
+        }
+
+        options.tier = evp::validate_tier::structural;
+        issues.clear();
+
+        EXPECT_FALSE(evp.validate(evp_source::from_memory(broken.data(), broken.size()), options, &issues));
+        ASSERT_TRUE(issues.size() == 2);
+        EXPECT_TRUE(issues[0].kind == evp::validate_issue::type::overlap);
+        EXPECT_TRUE(issues[1].kind == evp::validate_issue::type::duplicate);
+    }
+}
@@ -44,3 +44,221 @@ TEST(packing, v1_packing) {
 
     std::remove(output.c_str());
 }
+
+TEST(packing, v1_packing_async) {
+    evp evp;
+    evp.set_thread_pool(std::make_shared<evp_thread_pool>(2));
+
+    evp::pack_input input;
+    input.base = BASE_PATH + std::string("/tests/v1/resources/files_to_pack/subfolder_2");
+    input.files.push_back("text_3.txt");
+
+    std::string output = BASE_PATH + std::string("/tests/v1/resources/v1_packing_async_single_file.evp");
+    std::string valid  = BASE_PATH + std::string("/tests/v1/resources/single_file.evp");
+
+    evp_job job = evp.pack_async(input, output);
+    ASSERT_TRUE(job.is_valid());
+
+    auto r1 = job.wait();
+
+    EXPECT_TRUE(r1);
+    EXPECT_TRUE(job.get_status() == evp_job::status::finished);
+    EXPECT_TRUE(compare_files(output, valid));
+
+    std::remove(output.c_str());
+}
+
+TEST(packing, v1_packing_memory) {
+    evp evp;
+
+    std::string file  = BASE_PATH + std::string("/tests/v1/resources/files_to_pack/subfolder_2/text_3.txt");
+    std::string valid = BASE_PATH + std::string("/tests/v1/resources/single_file.evp");
+
+    std::ifstream        file_stream(file, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file_stream)), std::istreambuf_iterator<char>());
+
+    std::ifstream        valid_stream(valid, std::ios::binary);
+    std::vector<uint8_t> expected((std::istreambuf_iterator<char>(valid_stream)), std::istreambuf_iterator<char>());
+
+    evp::pack_source_input input;
+    input.entries.push_back({ "text_3.txt", evp_source::from_memory(data.data(), data.size()) });
+
+    std::vector<uint8_t> output;
+
+    auto r1 = evp.pack(input, evp_sink::from_memory(output));
+
+    EXPECT_TRUE(r1);
+    EXPECT_TRUE(output == expected);
+}
+
+TEST(packing, v1_packing_sequential) {
+    evp evp;
+
+    evp::pack_input input;
+    input.base = BASE_PATH + std::string("/tests/v1/resources/files_to_pack");
+    input.files.push_back("subfolder_1/text_1.txt");
+    input.files.push_back("subfolder_1/text_2.txt");
+    input.files.push_back("subfolder_2/text_3.txt");
+    input.files.push_back("text_1.txt");
+
+    std::string output = BASE_PATH + std::string("/tests/v1/resources/v1_packing_sequential.evp");
+
+    ASSERT_TRUE(evp.pack(input, output));
+
+    std::ifstream        output_stream(output, std::ios::binary);
+    std::vector<uint8_t> expected((std::istreambuf_iterator<char>(output_stream)), std::istreambuf_iterator<char>());
+
+    evp::pack_source_input source_input;
+    for (const auto& file : input.files)
+        source_input.entries.push_back({ file.string(), evp_source::from_file(input.base / file) });
+
+    // sink can't seek, archive has to be written front to back
+    std::vector<uint8_t> streamed;
+    auto sink = evp_sink::from_callback([&](const uint8_t* src, size_t size) {
+        streamed.insert(streamed.end(), src, src + size);
+        return true;
+    });
+
+    EXPECT_TRUE(evp.pack(source_input, sink));
+    EXPECT_TRUE(streamed == expected);
+
+    output_stream.close();
+    std::remove(output.c_str());
+}
+
+TEST(packing, v1_packing_hash_cache) {
+    evp evp;
+
+    evp::pack_input input;
+    input.base       = BASE_PATH + std::string("/tests/v1/resources/files_to_pack");
+    input.hash_cache = std::make_shared<evp_hash_cache>();
+    input.files.push_back("subfolder_1/text_1.txt");
+    input.files.push_back("subfolder_1/text_2.txt");
+    input.files.push_back("subfolder_2/text_3.txt");
+    input.files.push_back("text_1.txt");
+
+    std::string first  = BASE_PATH + std::string("/tests/v1/resources/v1_packing_hash_cache_1.evp");
+    std::string second = BASE_PATH + std::string("/tests/v1/resources/v1_packing_hash_cache_2.evp");
+    std::string cache  = BASE_PATH + std::string("/tests/v1/resources/v1_packing_hash_cache.bin");
+
+    ASSERT_TRUE(evp.pack(input, first));
+    EXPECT_EQ(input.hash_cache->size(), input.files.size());
+
+    ASSERT_TRUE(input.hash_cache->save(cache));
+
+    input.hash_cache = std::make_shared<evp_hash_cache>();
+    ASSERT_TRUE(input.hash_cache->load(cache));
+    EXPECT_EQ(input.hash_cache->size(), input.files.size());
+
+    // unchanged files are copied from the previous archive with their cached hashes
+    input.previous_archive = first;
+
+    ASSERT_TRUE(evp.pack(input, second));
+    EXPECT_TRUE(compare_files(first, second));
+
+    // cached hash is trusted while the file stays the same
+    FILE_PATH              file  = input.base / "text_1.txt";
+    evp_hash_cache::stamp  stamp = {};
+    evp_hash_cache::hash_t hash  = {};
+
+    ASSERT_TRUE(evp_hash_cache::read_stamp(file, stamp));
+
+    hash.fill(0xAB);
+    input.hash_cache->set(file, stamp, hash);
+
+    ASSERT_TRUE(evp.pack(input, second));
+
+    std::vector<evp_fd> fds;
+    ASSERT_TRUE(evp.get_archive_fds(second, fds));
+
+    auto it = std::find_if(fds.begin(), fds.end(), [](const evp_fd& fd) { return fd.file == "text_1.txt"; });
+    ASSERT_TRUE(it != fds.end());
+    EXPECT_TRUE(it->hash == hash);
+
+    // and ignored once it changes
+    stamp.mtime += 1;
+    input.hash_cache->set(file, stamp, hash);
+
+    ASSERT_TRUE(evp.pack(input, second));
+    EXPECT_TRUE(compare_files(first, second));
+
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+    std::remove(cache.c_str());
+}
+
+TEST(packing, v1_packing_access_trace) {
+    evp evp;
+
+    evp::pack_source_input input;
+
+    for (const char* file : { "a/1.txt", "b/1.txt", "a/2.txt", "c.txt", "b/2.txt", "a/3.txt" }) {
+        static const uint8_t data[] = { 'e', 'v', 'p' };
+        input.entries.push_back({ file, evp_source::from_memory(data, sizeof(data)) });
+    }
+
+    // traced entries first by time, unknown names are skipped
+    input.access_trace = {
+        { "b/2.txt", 20U }, { "missing.txt", 5U }, { "a/3.txt", 10U }, { "b/2.txt", 30U }
+    };
+
+    std::vector<uint8_t> output;
+    ASSERT_TRUE(evp.pack(input, evp_sink::from_memory(output)));
+
+    std::vector<evp_fd> fds;
+    ASSERT_TRUE(evp.get_archive_fds(evp_source::from_memory(output.data(), output.size()), fds));
+
+    std::sort(fds.begin(), fds.end(), [](const evp_fd& a, const evp_fd& b) {
+        return a.data_offset < b.data_offset;
+    });
+
+    // rest grouped by directory in order of first appearance
+    std::vector<std::string> expected = { "a/3.txt", "b/2.txt", "a/1.txt", "a/2.txt", "b/1.txt", "c.txt" };
+
+    ASSERT_EQ(fds.size(), expected.size());
+    for (size_t i = 0; i < fds.size(); i++)
+        EXPECT_EQ(fds[i].file, expected[i]);
+}
+
+TEST(packing, v1_packing_aligned) {
+    evp evp;
+
+    evp::pack_input input;
+    input.base                = BASE_PATH + std::string("/tests/v1/resources/files_to_pack");
+    input.alignment           = 4096U;
+    input.alignment_threshold = 700U;
+    input.files.push_back("subfolder_1/text_1.txt");
+    input.files.push_back("subfolder_1/text_2.txt");
+    input.files.push_back("subfolder_2/text_3.txt");
+    input.files.push_back("text_1.txt");
+
+    std::string output = BASE_PATH + std::string("/tests/v1/resources/v1_packing_aligned.evp");
+
+    ASSERT_TRUE(evp.pack(input, output));
+
+    std::vector<evp_fd> fds;
+    ASSERT_TRUE(evp.get_archive_fds(output, fds));
+    ASSERT_EQ(fds.size(), input.files.size());
+
+    for (const evp_fd& fd : fds) {
+        if (fd.data_size >= input.alignment_threshold) {
+            EXPECT_EQ(fd.data_offset % input.alignment, 0U);
+        }
+
+        // padding stays invisible to readers
+        std::vector<uint8_t> buffer;
+        ASSERT_TRUE(evp.get_file(output, fd.file, buffer));
+
+        std::ifstream        stream(input.base / fd.file, std::ios::binary);
+        std::vector<uint8_t> contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+        EXPECT_TRUE(buffer == contents);
+    }
+
+    EXPECT_TRUE(evp.validate_files(output));
+
+    input.alignment = 3000U;
+    EXPECT_FALSE(evp.pack(input, output));
+
+    std::remove(output.c_str());
+}
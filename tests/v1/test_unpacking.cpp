@@ -6,6 +6,7 @@
 #include <string>
 #include <algorithm>
 #include <regex>
+#include <thread>
 
 using namespace libevp;
 
@@ -55,6 +56,48 @@ TEST(unpacking, v1_unpacking) {
     std::filesystem::remove_all(output);
 }
 
+TEST(unpacking, v1_unpacking_directories) {
+    evp evp;
+
+    std::string archive = BASE_PATH + std::string("/tests/v1/resources/v1_unpacking_directories.evp");
+    std::string output  = BASE_PATH + std::string("/tests/v1/resources/unpack_directories_here/");
+    std::string valid   = BASE_PATH + std::string("/tests/v1/resources/files_to_pack/");
+
+    std::vector<std::string> files = { "text_1.txt", "subfolder_1/text_1.txt", "subfolder_1/text_2.txt", "subfolder_2/text_3.txt" };
+
+    evp::pack_input pack_input;
+    pack_input.base = valid;
+
+    for (const std::string& file : files)
+        pack_input.files.push_back(file);
+
+    ASSERT_TRUE(evp.pack(pack_input, archive));
+
+    evp::unpack_input input;
+    input.archive = archive;
+
+    std::filesystem::create_directories(output);
+
+    auto r1 = evp.unpack(input, output);
+    ASSERT_TRUE(r1);
+
+    for (const std::string& file : files)
+        EXPECT_TRUE(compare_files(output + file, valid + file));
+
+    // unpacking over existing files and directories truncates them,
+    // read through user space this time
+    input.zero_copy = false;
+
+    auto r2 = evp.unpack(input, output);
+    ASSERT_TRUE(r2);
+
+    for (const std::string& file : files)
+        EXPECT_TRUE(compare_files(output + file, valid + file));
+
+    std::filesystem::remove_all(output);
+    std::remove(archive.c_str());
+}
+
 TEST(unpacking, v1_get_file) {
     evp evp;
 
@@ -92,3 +135,191 @@ TEST(unpacking, v1_get_file_stream) {
 
     ASSERT_TRUE(compare_buffers(buffer, contents));
 }
+
+TEST(unpacking, v1_get_file_cached) {
+    evp evp;
+    evp.set_cache(std::make_shared<evp_cache>(1024 * 1024));
+
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+    std::string valid = BASE_PATH + std::string("/tests/v1/resources/files_to_pack/text_1.txt");
+
+    std::vector<evp_fd> files = {};
+    ASSERT_TRUE(evp.get_archive_fds(input, files));
+    ASSERT_TRUE(files.size() == 4);
+
+    evp_cache::buffer_ptr_t b1, b2;
+
+    ASSERT_TRUE(evp.get_file(input, files[3], b1));
+    ASSERT_TRUE(evp.get_file(input, files[3], b2));
+    ASSERT_TRUE(b1 && b1 == b2);
+
+    std::ifstream stream(valid, std::ios::in | std::ios::binary);
+    ASSERT_TRUE(stream.is_open());
+
+    std::vector<uint8_t> contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    ASSERT_TRUE(compare_buffers(*b1, contents));
+
+    auto stats = evp.get_cache()->get_stats();
+    EXPECT_TRUE(stats.hits == 1);
+    EXPECT_TRUE(stats.misses == 1);
+    EXPECT_TRUE(stats.entries == 1);
+
+    // by name, second lookup is served before the archive is parsed
+    std::vector<uint8_t> n1, n2;
+
+    ASSERT_TRUE(evp.get_file(input, files[2].file, n1));
+    ASSERT_TRUE(evp.get_file(input, files[2].file, n2));
+    EXPECT_TRUE(compare_buffers(n1, n2));
+
+    stats = evp.get_cache()->get_stats();
+    EXPECT_TRUE(stats.hits == 2);
+    EXPECT_TRUE(stats.misses == 2);
+    EXPECT_TRUE(stats.entries == 2);
+
+    evp_cache::buffer_ptr_t b3;
+    ASSERT_TRUE(evp.get_file(input, files[2], b3));
+    EXPECT_TRUE(compare_buffers(*b3, n1));
+    EXPECT_TRUE(evp.get_cache()->get_stats().entries == 2);
+
+    EXPECT_FALSE(evp.get_file(input, "missing.txt", n1));
+
+    // same message as without a cache
+    auto missing = evp.get_file(BASE_PATH + std::string("/tests/v1/resources/missing.evp"), files[2].file, n1);
+    EXPECT_FALSE(missing);
+    EXPECT_TRUE(missing.message == "File not found.");
+}
+
+TEST(unpacking, v1_unpacking_progress) {
+    evp evp;
+
+    evp::unpack_input input;
+    input.archive = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    std::string output = BASE_PATH + std::string("/tests/v1/resources/unpack_progress_here/");
+    std::filesystem::create_directories(output);
+
+    uint64_t last_done  = 0U;
+    uint64_t last_total = 0U;
+
+    evp_context context;
+    context.progress_interval = std::chrono::milliseconds(0);
+    context.progress_callback = [&](uint64_t done, uint64_t total) {
+        last_done  = done;
+        last_total = total;
+    };
+
+    auto r1 = evp.unpack_async(input, output, &context).wait();
+
+    EXPECT_TRUE(r1);
+    EXPECT_TRUE(last_total == 2999);
+    EXPECT_TRUE(last_done == last_total);
+
+    std::filesystem::remove_all(output);
+}
+
+TEST(unpacking, v1_unpacking_callback_throws) {
+    evp evp;
+
+    evp::unpack_input input;
+    input.archive = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    std::string output = BASE_PATH + std::string("/tests/v1/resources/unpack_throws_here/");
+    std::filesystem::create_directories(output);
+
+    evp_context context;
+    context.progress_interval = std::chrono::milliseconds(0);
+    context.progress_callback = [](uint64_t, uint64_t) {
+        throw 1;
+    };
+
+    // job has to finish even if a callback throws a non-std exception
+    auto r1 = evp.unpack_async(input, output, &context).wait();
+
+    EXPECT_TRUE(r1.status == evp_result::status::failure);
+
+    std::filesystem::remove_all(output);
+}
+
+TEST(unpacking, v1_validate_cancelled) {
+    evp evp;
+
+    std::string input = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    std::atomic_bool cancel = false;
+
+    evp_context context;
+    context.cancel            = &cancel;
+    context.progress_interval = std::chrono::milliseconds(0);
+    context.progress_callback = [&](uint64_t, uint64_t) {
+        cancel = true;
+    };
+
+    auto r1 = evp.validate_files(input, nullptr, &context);
+
+    EXPECT_TRUE(r1.status == evp_result::status::cancelled);
+}
+
+TEST(unpacking, v1_unpacking_stats) {
+    evp evp;
+
+    evp::unpack_input input;
+    input.archive = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    std::string output = BASE_PATH + std::string("/tests/v1/resources/unpack_stats_here/");
+    std::filesystem::create_directories(output);
+
+    evp_stats stats;
+
+    evp_context context;
+    context.stats = &stats;
+
+    auto r1 = evp.unpack_async(input, output, &context).wait();
+    auto s1 = stats.get();
+
+    EXPECT_TRUE(r1);
+    EXPECT_TRUE(s1.entry_count == 4);
+    EXPECT_TRUE(s1.bytes_read == 2999);
+    EXPECT_TRUE(s1.bytes_written == 2999);
+    EXPECT_TRUE(s1.largest_entry.data_offset == 76);
+    EXPECT_TRUE(s1.largest_entry.value == 1062);
+    EXPECT_TRUE(s1.parse_time.count() > 0);
+
+    stats.reset();
+    EXPECT_TRUE(stats.get().entry_count == 0);
+
+    std::filesystem::remove_all(output);
+}
+
+TEST(unpacking, v1_unpacking_trace) {
+    evp evp;
+
+    evp::unpack_input input;
+    input.archive = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+
+    std::string output = BASE_PATH + std::string("/tests/v1/resources/unpack_trace_here/");
+    std::filesystem::create_directories(output);
+
+    evp_trace trace;
+
+    evp_context context;
+    context.trace = &trace;
+
+    auto r1 = evp.unpack_async(input, output, &context).wait();
+    auto j1 = trace.to_json();
+
+    EXPECT_TRUE(r1);
+    EXPECT_TRUE(trace.size() > 4);
+    EXPECT_TRUE(j1.find("\"name\":\"determine_format\"") != std::string::npos);
+    EXPECT_TRUE(j1.find("\"file\":\"subfolder_1/text_1.txt\"") != std::string::npos);
+
+    // thread ids restart after clearing
+    trace.clear();
+    std::thread([&] { trace.add_span({ "span", "test" }); }).join();
+
+    auto j2 = trace.to_json();
+
+    EXPECT_TRUE(trace.size() == 1);
+    EXPECT_TRUE(j2.find("\"tid\":1") != std::string::npos);
+
+    std::filesystem::remove_all(output);
+}
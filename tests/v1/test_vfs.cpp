@@ -0,0 +1,52 @@
+#include <libevp.hpp>
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace libevp;
+
+static std::vector<uint8_t> read_file(const std::string& path) {
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+}
+
+TEST(vfs, shadowing) {
+    evp evp;
+
+    evp::pack_input input;
+    input.base = BASE_PATH + std::string("/tests/v1/resources/files_to_pack/subfolder_1");
+    input.files.push_back("text_1.txt");
+
+    std::string base  = BASE_PATH + std::string("/tests/v1/resources/multiple_files.evp");
+    std::string patch = BASE_PATH + std::string("/tests/v1/resources/vfs_patch.evp");
+
+    ASSERT_TRUE(evp.pack(input, patch));
+
+    auto base_contents  = read_file(BASE_PATH + std::string("/tests/v1/resources/files_to_pack/text_1.txt"));
+    auto patch_contents = read_file(BASE_PATH + std::string("/tests/v1/resources/files_to_pack/subfolder_1/text_1.txt"));
+
+    evp_vfs vfs;
+    ASSERT_TRUE(vfs.mount(base, 0));
+    ASSERT_TRUE(vfs.mount(patch, 1));
+    EXPECT_FALSE(vfs.mount(patch, 1));
+    EXPECT_TRUE(vfs.size() == 4);
+
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(vfs.get_file("text_1.txt", buffer));
+    EXPECT_TRUE(buffer == patch_contents);
+
+    ASSERT_TRUE(vfs.get_file("subfolder_2/text_3.txt", buffer));
+
+    evp_vfs::entry entry;
+    ASSERT_TRUE(vfs.find("subfolder_1\\text_2.txt", entry));
+    EXPECT_TRUE(entry.fd.file == "subfolder_1/text_2.txt");
+
+    ASSERT_TRUE(vfs.unmount(patch));
+    ASSERT_TRUE(vfs.get_file("text_1.txt", buffer));
+    EXPECT_TRUE(buffer == base_contents);
+    EXPECT_FALSE(vfs.unmount(patch));
+
+    std::remove(patch.c_str());
+}